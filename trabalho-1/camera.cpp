@@ -0,0 +1,131 @@
+#include "camera.h"
+#include <cmath>
+
+namespace {
+
+const float DEG = float(M_PI / 180.0);
+
+// c = a * b, matrizes 4x4 em coluna
+void multiply(const float a[16], const float b[16], float c[16]) {
+	for (int col = 0; col < 4; ++col)
+		for (int row = 0; row < 4; ++row) {
+			float s = 0.0f;
+			for (int k = 0; k < 4; ++k)
+				s += a[k * 4 + row] * b[col * 4 + k];
+			c[col * 4 + row] = s;
+		}
+}
+
+void identity(float m[16]) {
+	for (int k = 0; k < 16; ++k)
+		m[k] = k % 5 == 0 ? 1.0f : 0.0f;
+}
+
+// m = m * r, com r a rotação de glRotatef(angle, x, y, z) em torno de um eixo unitário
+void rotate(float m[16], float angle, float x, float y, float z) {
+	float c = std::cos(angle * DEG), s = std::sin(angle * DEG), t = 1.0f - c;
+	float r[16] = {t * x * x + c,     t * x * y + s * z, t * x * z - s * y, 0.0f,
+	               t * x * y - s * z, t * y * y + c,     t * y * z + s * x, 0.0f,
+	               t * x * z + s * y, t * y * z - s * x, t * z * z + c,     0.0f,
+	               0.0f,              0.0f,              0.0f,              1.0f};
+	float out[16];
+	multiply(m, r, out);
+	for (int k = 0; k < 16; ++k)
+		m[k] = out[k];
+}
+
+// base do gluLookAt(olho, alvo, (0,1,0)): s para a direita, u para cima e
+// f para a frente
+void lookAtBasis(const float e[3], const float t[3], float s[3], float u[3], float f[3]) {
+	f[0] = t[0] - e[0], f[1] = t[1] - e[1], f[2] = t[2] - e[2];
+	float fl = std::sqrt(f[0] * f[0] + f[1] * f[1] + f[2] * f[2]);
+	f[0] /= fl, f[1] /= fl, f[2] /= fl;
+	// s = f x up, u = s x f
+	s[0] = -f[2], s[1] = 0.0f, s[2] = f[0];
+	float sl = std::sqrt(s[0] * s[0] + s[2] * s[2]);
+	if (sl > 0.0f)
+		s[0] /= sl, s[2] /= sl;
+	u[0] = s[1] * f[2] - s[2] * f[1];
+	u[1] = s[2] * f[0] - s[0] * f[2];
+	u[2] = s[0] * f[1] - s[1] * f[0];
+}
+
+// desfaz Rx * Ry (glRotatef das rotações da malha) no vetor q
+void unrotateMesh(float rotX, float rotY, float q[3]) {
+	float cx = std::cos(rotX * DEG), sx = std::sin(rotX * DEG);
+	float cy = std::cos(rotY * DEG), sy = std::sin(rotY * DEG);
+	float ry = cx * q[1] + sx * q[2], rz = -sx * q[1] + cx * q[2];
+	float x = cy * q[0] - sy * rz;
+	q[2] = sy * q[0] + cy * rz;
+	q[0] = x;
+	q[1] = ry;
+}
+
+} // namespace
+
+void OrbitCamera::eye(float &x, float &y, float &z) const {
+	float radAz = azimuth * DEG;
+	float radEl = elevation * DEG;
+	x = targetX + radius * std::cos(radEl) * std::sin(radAz);
+	y = targetY + radius * std::sin(radEl);
+	z = targetZ + radius * std::cos(radEl) * std::cos(radAz);
+}
+
+void OrbitCamera::modelEye(float &x, float &y, float &z) const {
+	// o modelo é translação(-alvo) * Rx * Ry; aplica a inversa em olho + alvo
+	float q[3];
+	eye(q[0], q[1], q[2]);
+	q[0] += targetX;
+	q[1] += targetY;
+	q[2] += targetZ;
+	unrotateMesh(meshRotX, meshRotY, q);
+	x = q[0];
+	y = q[1];
+	z = q[2];
+}
+
+void OrbitCamera::modelLight(float &x, float &y, float &z) const {
+	// do olho para o mundo pela transposta da rotação da vista (linhas s,
+	// u, -f), depois desfaz as rotações da malha
+	float e[3], t[3] = {targetX, targetY, targetZ}, s[3], u[3], f[3];
+	eye(e[0], e[1], e[2]);
+	lookAtBasis(e, t, s, u, f);
+	const float ll = std::sqrt(LIGHT[0] * LIGHT[0] + LIGHT[1] * LIGHT[1] + LIGHT[2] * LIGHT[2]);
+	const float l[3] = {LIGHT[0] / ll, LIGHT[1] / ll, LIGHT[2] / ll};
+	float q[3];
+	for (int k = 0; k < 3; ++k)
+		q[k] = l[0] * s[k] + l[1] * u[k] - l[2] * f[k];
+	unrotateMesh(meshRotX, meshRotY, q);
+	x = q[0];
+	y = q[1];
+	z = q[2];
+}
+
+void OrbitCamera::matrix(float aspect, float m[16]) const {
+	// gluPerspective
+	float f = 1.0f / std::tan(FOVY * DEG / 2.0f);
+	float proj[16] = {f / aspect, 0.0f, 0.0f, 0.0f, 0.0f, f, 0.0f, 0.0f,
+	                  0.0f, 0.0f, (Z_FAR + Z_NEAR) / (Z_NEAR - Z_FAR), -1.0f,
+	                  0.0f, 0.0f, 2.0f * Z_FAR * Z_NEAR / (Z_NEAR - Z_FAR), 0.0f};
+
+	// gluLookAt(olho, alvo, (0,1,0))
+	float e[3], t[3] = {targetX, targetY, targetZ}, s[3], u[3], fw[3];
+	eye(e[0], e[1], e[2]);
+	lookAtBasis(e, t, s, u, fw);
+	float view[16] = {s[0], u[0], -fw[0], 0.0f, s[1], u[1], -fw[1], 0.0f, s[2], u[2], -fw[2], 0.0f,
+	                  -(s[0] * e[0] + s[1] * e[1] + s[2] * e[2]), -(u[0] * e[0] + u[1] * e[1] + u[2] * e[2]),
+	                  fw[0] * e[0] + fw[1] * e[1] + fw[2] * e[2], 1.0f};
+
+	// glTranslatef(-alvo) e as rotações da malha
+	float model[16];
+	identity(model);
+	model[12] = -targetX;
+	model[13] = -targetY;
+	model[14] = -targetZ;
+	rotate(model, meshRotX, 1.0f, 0.0f, 0.0f);
+	rotate(model, meshRotY, 0.0f, 1.0f, 0.0f);
+
+	float pv[16];
+	multiply(proj, view, pv);
+	multiply(pv, model, m);
+}
@@ -0,0 +1,39 @@
+#ifndef CAMERA_H
+#define CAMERA_H
+
+// Câmera orbital do visualizador: o olho gira em torno do alvo em
+// coordenadas esféricas (raio, azimute e elevação, em graus), e a malha
+// ainda pode girar em torno dos próprios eixos X e Y. O display() do GLUT
+// monta a mesma transformação com gluPerspective, gluLookAt, glTranslatef e
+// glRotatef; matrix() a reproduz para quem desenha sem OpenGL.
+struct OrbitCamera {
+	// Ponto central do gráfico (alvo)
+	float targetX = 0.0f, targetY = 1.5f, targetZ = 0.0f;
+	float radius = 12.0f; // distância entre câmera e alvo
+	float azimuth = 0.0f; // ângulo horizontal (gira em torno do eixo Y do alvo)
+	float elevation = 10.0f; // ângulo vertical (inclinação acima do plano XZ)
+	float meshRotX = 0.0f; // rotação da malha em torno do eixo X local
+	float meshRotY = 0.0f; // rotação da malha em torno do eixo Y local
+
+	// projeção, como no reshape()
+	static constexpr float FOVY = 45.0f, Z_NEAR = 0.1f, Z_FAR = 100.0f;
+	// Luz direcional presa ao olho (direção em coordenadas do olho), como a
+	// GL_LIGHT0 do visualizador: um vértice de cor c com normal n fica com
+	// c (GLOBAL_AMBIENT + LIGHT_AMBIENT + LIGHT_DIFFUSE max(0, n.l)).
+	static constexpr float LIGHT[3] = {-0.3f, 0.6f, 1.0f};
+	static constexpr float LIGHT_AMBIENT = 0.2f, LIGHT_DIFFUSE = 0.7f, GLOBAL_AMBIENT = 0.2f;
+
+	void reset() { *this = OrbitCamera(); }
+	// posição do olho
+	void eye(float &x, float &y, float &z) const;
+	// posição do olho nas coordenadas da malha (x, u, y), desfeitas a
+	// translação e as rotações da malha
+	void modelEye(float &x, float &y, float &z) const;
+	// direção unitária da luz nas coordenadas da malha, para n.l com as
+	// normais do campo
+	void modelLight(float &x, float &y, float &z) const;
+	// projeção * vista * modelo, em coluna (como glLoadMatrixf)
+	void matrix(float aspect, float m[16]) const;
+};
+
+#endif
@@ -0,0 +1,216 @@
+#include "cholesky.h"
+#include "dst.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <list>
+#include <mutex>
+
+namespace {
+
+const size_t CACHE_BUDGET = size_t(1) << 30;
+
+std::mutex cacheMutex;
+std::list<std::shared_ptr<const BandedCholesky>> cache; // mais recente na frente
+size_t cacheBytes = 0;
+
+} // namespace
+
+size_t BandedCholesky::bytesFor(int N, int M) {
+	size_t n = size_t(N - 1) * (M - 1);
+	int p = std::min(N, M) - 1;
+	return n * (p + 1) * sizeof(double);
+}
+
+size_t BandedCholesky::order(int i, int j) const {
+	return yFast ? j + size_t(i) * (M - 1) : i + size_t(j) * (N - 1);
+}
+
+BandedCholesky::BandedCholesky(int N_, int M_, const SolverMonitor *monitor)
+    : N(N_), M(M_), n(size_t(N_ - 1) * (M_ - 1)) {
+	yFast = M < N;
+	// pontos por linha da numeração, que é também a distância até o vizinho
+	// na dimensão lenta
+	p = yFast ? M - 1 : N - 1;
+	const double cx = N * N / (X_MAX * X_MAX), cy = M * M / (Y_MAX * Y_MAX);
+	const double cFast = yFast ? cy : cx, cSlow = yFast ? cx : cy;
+	const int w = p + 1;
+
+	perm.resize(n);
+	for (int j = 0; j < M - 1; ++j)
+		for (int i = 0; i < N - 1; ++i)
+			perm[i + size_t(j) * (N - 1)] = order(i, j);
+
+	// Cholesky por linhas: L(k,c) = (A(k,c) - <L(k,:), L(c,:)>) / L(c,c). As
+	// duas linhas guardam as colunas em posições consecutivas, então o
+	// produto interno é um laço contíguo.
+	band.assign(n * w, 0.0);
+	for (size_t k = 0; k < n; ++k) {
+		// a cada linha do fator (O(p²) operações) vê se o solve foi
+		// cancelado, para a interface não esperar o fim
+		if (monitor && monitor->cancelled()) {
+			std::vector<double>().swap(band);
+			return;
+		}
+		double *Lk = &band[k * w];
+		const size_t first = k > size_t(p) ? k - p : 0;
+		for (size_t c = first; c <= k; ++c) {
+			double a = 0.0;
+			if (c == k)
+				a = 2 * cx + 2 * cy;
+			else if (c + 1 == k && k % p != 0)
+				a = -cFast;
+			else if (c + p == k)
+				a = -cSlow;
+			const double *Lc = &band[c * w];
+			// colunas comuns: de max(first, c-p) até c-1
+			const size_t lo = std::max(first, c > size_t(p) ? c - p : 0);
+			const double *rk = Lk + (lo + p - k), *rc = Lc + (lo + p - c);
+			// quatro somas parciais independentes para o laço vetorizar
+			const size_t len = c - lo;
+			double s4[4] = {0.0, 0.0, 0.0, 0.0};
+			size_t l = 0;
+			for (; l + 4 <= len; l += 4)
+				for (int q = 0; q < 4; ++q)
+					s4[q] += rk[l + q] * rc[l + q];
+			double s = (s4[0] + s4[1]) + (s4[2] + s4[3]);
+			for (; l < len; ++l)
+				s += rk[l] * rc[l];
+			if (c == k)
+				Lk[p] = std::sqrt(a - s);
+			else
+				Lk[c + p - k] = (a - s) / Lc[p];
+		}
+	}
+}
+
+namespace {
+
+// Substituições para frente e para trás com W lados direitos entrelaçados
+// em y[k*W + r]; W fixo em tempo de compilação deixa os acumuladores em
+// registradores
+template <int W> void bandSolve(const double *band, size_t n, int p, double *y) {
+	const int w = p + 1;
+	// L y = b
+	for (size_t k = 0; k < n; ++k) {
+		const double *Lk = band + k * w;
+		const size_t first = k > size_t(p) ? k - p : 0;
+		double s[W];
+		for (int r = 0; r < W; ++r)
+			s[r] = y[k * W + r];
+		for (size_t c = first; c < k; ++c) {
+			const double l = Lk[c + p - k];
+			const double *yc = y + c * W;
+			for (int r = 0; r < W; ++r)
+				s[r] -= l * yc[r];
+		}
+		const double inv = 1.0 / Lk[p];
+		for (int r = 0; r < W; ++r)
+			y[k * W + r] = s[r] * inv;
+	}
+	// L^T x = y, de trás para frente: ao fixar x(k), desconta a coluna k de
+	// L (a linha k guardada) das incógnitas anteriores
+	for (size_t k = n; k-- > 0;) {
+		const double *Lk = band + k * w;
+		const size_t first = k > size_t(p) ? k - p : 0;
+		const double inv = 1.0 / Lk[p];
+		double xk[W];
+		for (int r = 0; r < W; ++r)
+			xk[r] = y[k * W + r] *= inv;
+		for (size_t c = first; c < k; ++c) {
+			const double l = Lk[c + p - k];
+			double *yc = y + c * W;
+			for (int r = 0; r < W; ++r)
+				yc[r] -= l * xk[r];
+		}
+	}
+}
+
+} // namespace
+
+void BandedCholesky::solve(const double *g, double *u, int nrhs) const {
+	std::vector<double> y;
+	for (int r0 = 0; r0 < nrhs; r0 += RHS_BLOCK) {
+		const int nb = std::min(RHS_BLOCK, nrhs - r0);
+		// largura do bloco: a menor potência de 2 que cabe os nb vetores
+		int W = 1;
+		while (W < nb)
+			W *= 2;
+		y.assign(n * W, 0.0);
+		// A = -Δh, então o lado direito é -g
+		for (int r = 0; r < nb; ++r) {
+			const double *gr = g + size_t(r0 + r) * n;
+			for (size_t k = 0; k < n; ++k)
+				y[perm[k] * W + r] = -gr[k];
+		}
+
+		switch (W) {
+		case 1:
+			bandSolve<1>(band.data(), n, p, y.data());
+			break;
+		case 2:
+			bandSolve<2>(band.data(), n, p, y.data());
+			break;
+		case 4:
+			bandSolve<4>(band.data(), n, p, y.data());
+			break;
+		default:
+			bandSolve<RHS_BLOCK>(band.data(), n, p, y.data());
+			break;
+		}
+
+		for (int r = 0; r < nb; ++r) {
+			double *ur = u + size_t(r0 + r) * n;
+			for (size_t k = 0; k < n; ++k)
+				ur[k] = y[perm[k] * W + r];
+		}
+	}
+}
+
+std::shared_ptr<const BandedCholesky> choleskyFactor(int N, int M, const SolverMonitor *monitor) {
+	{
+		std::lock_guard<std::mutex> lock(cacheMutex);
+		for (auto it = cache.begin(); it != cache.end(); ++it)
+			if ((*it)->gridN() == N && (*it)->gridM() == M) {
+				cache.splice(cache.begin(), cache, it);
+				return cache.front();
+			}
+	}
+	auto factor = std::make_shared<const BandedCholesky>(N, M, monitor);
+	if (!factor->complete())
+		return nullptr;
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	cache.push_front(factor);
+	cacheBytes += factor->bytes();
+	while (cacheBytes > CACHE_BUDGET && cache.size() > 1) {
+		cacheBytes -= cache.back()->bytes();
+		cache.pop_back();
+	}
+	return factor;
+}
+
+SolverStats solveCholesky(int N, int M, float *solution, const SolverOptions &opt) {
+	if (BandedCholesky::bytesFor(N, M) > CACHE_BUDGET) {
+		fprintf(stderr, "fatoração de %dx%d passa de %zu MiB; resolvendo pelo DST\n", N, M, CACHE_BUDGET >> 20);
+		return solveDST(N, M, solution, opt);
+	}
+	auto t0 = std::chrono::steady_clock::now();
+	const size_t n = size_t(N - 1) * (M - 1);
+	std::vector<double> g(n), u(n);
+	poissonRHS(N, M, g.data());
+	SolverStats st;
+	auto factor = choleskyFactor(N, M, opt.monitor);
+	if (!factor) {
+		st.cancelled = true;
+		st.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+		return st;
+	}
+	factor->solve(g.data(), u.data(), 1);
+	for (size_t k = 0; k < n; ++k)
+		solution[k] = float(u[k]);
+
+	st.residual = relativeResidual(N, M, u.data(), g.data());
+	st.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+	return st;
+}
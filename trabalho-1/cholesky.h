@@ -0,0 +1,59 @@
+#ifndef CHOLESKY_H
+#define CHOLESKY_H
+
+#include "poisson.h"
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Fatoração de Cholesky em banda de A = -Δh na malha N x M. As incógnitas
+// são numeradas com a menor dimensão variando mais rápido, então a banda tem
+// largura p = min(N, M) - 1 e a fatoração custa O(n p²) operações e n(p+1)
+// doubles. Depois de fatorada, cada solução custa O(n p).
+class BandedCholesky {
+public:
+	// quantos lados direitos cada passada pelo fator resolve junto
+	static const int RHS_BLOCK = 8;
+
+	// Fatora; se `monitor` pedir para parar no meio, desiste e fica
+	// incompleta (complete() falso, sem o fator).
+	BandedCholesky(int N, int M, const SolverMonitor *monitor = nullptr);
+
+	int gridN() const { return N; }
+	int gridM() const { return M; }
+	size_t unknowns() const { return n; }
+	int bandwidth() const { return p; }
+	bool complete() const { return !band.empty(); }
+	size_t bytes() const { return band.size() * sizeof(double); }
+	// memória que a fatoração de N x M ocuparia, para decidir antes de fatorar
+	static size_t bytesFor(int N, int M);
+
+	// Resolve Δh u = g para `nrhs` lados direitos no layout interior; o r-ésimo
+	// está em g + r*unknowns() e a solução vai para u + r*unknowns(). Os lados
+	// direitos passam pelo fator em blocos de RHS_BLOCK: cada linha do fator é
+	// lida uma vez por bloco e aplicada a todos os vetores do bloco.
+	void solve(const double *g, double *u, int nrhs) const;
+
+private:
+	size_t order(int i, int j) const; // índice na numeração da banda do ponto interior (i,j), base 0
+
+	int N, M;
+	size_t n;
+	int p;
+	bool yFast; // true quando a numeração percorre y primeiro
+	std::vector<double> band; // linha k: L(k, k-p .. k), diagonal por último
+	std::vector<size_t> perm; // posição na banda de cada índice do layout interior
+};
+
+// Fatorações já feitas ficam num cache do processo (as menos usadas saem
+// quando o total passa de 1 GiB); pedir a mesma malha de novo não refatora.
+// Devolve nullptr se `monitor` cancelou a fatoração, que não entra no cache.
+std::shared_ptr<const BandedCholesky> choleskyFactor(int N, int M, const SolverMonitor *monitor = nullptr);
+
+// Resolve o problema pela fatoração do cache. Se a fatoração passar do
+// orçamento de memória do cache, avisa e resolve pelo DST. Cancelado por
+// opt.monitor durante a fatoração, volta com stats.cancelled e sem mexer em
+// `solution`.
+SolverStats solveCholesky(int N, int M, float *solution, const SolverOptions &opt);
+
+#endif
@@ -0,0 +1,82 @@
+#include "colormap.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+const char *const COLORMAPS[] = {"ramp", "viridis", "turbo"};
+
+void ramp(float t, float rgb[3]) {
+	if (t < 0.25f) {
+		// Azul para ciano
+		rgb[0] = 0.0f, rgb[1] = 4.0f * t, rgb[2] = 1.0f;
+	} else if (t < 0.5f) {
+		// Ciano para verde
+		rgb[0] = 0.0f, rgb[1] = 1.0f, rgb[2] = 1.0f - 4.0f * (t - 0.25f);
+	} else if (t < 0.75f) {
+		// Verde para amarelo
+		rgb[0] = 4.0f * (t - 0.5f), rgb[1] = 1.0f, rgb[2] = 0.0f;
+	} else {
+		// Amarelo para vermelho
+		rgb[0] = 1.0f, rgb[1] = 1.0f - 4.0f * (t - 0.75f), rgb[2] = 0.0f;
+	}
+}
+
+// Viridis e turbo por ajustes polinomiais de grau 6 das tabelas originais
+// (matplotlib e Google); c[k] multiplica t^k
+const double VIRIDIS[7][3] = {
+    {0.2777273272234177, 0.005407344544966578, 0.3340998053353061},
+    {0.1050930431085774, 1.404613529898575, 1.384590162594685},
+    {-0.3308618287255563, 0.214847559468213, 0.09509516302823659},
+    {-4.634230498983486, -5.799100973351585, -19.33244095627987},
+    {6.228269936347081, 14.17993336680509, 56.69055260068105},
+    {4.776384997670288, -13.74514537774601, -65.35303263337234},
+    {-5.435455855934631, 4.645852612178535, 26.3124352495832},
+};
+const double TURBO[7][3] = {
+    {0.1140890109226559, 0.06288340699912215, 0.2248337216805064},
+    {6.716419496985708, 3.182286745507602, 7.571581586103393},
+    {-66.09402360453038, -4.9279827041226, -10.09439367561635},
+    {228.7660791526501, 25.04986699771073, -91.54105330182436},
+    {-334.8351565777451, -69.31749712757485, 288.5858850615712},
+    {218.7637218434795, 67.52150567819112, -305.2045772184957},
+    {-52.88903478218835, -21.54527364654712, 110.5174647748972},
+};
+
+void polynomial(const double c[7][3], float t, float rgb[3]) {
+	for (int ch = 0; ch < 3; ++ch) {
+		double v = 0.0;
+		for (int k = 6; k >= 0; --k)
+			v = v * t + c[k][ch];
+		rgb[ch] = float(v);
+	}
+}
+
+} // namespace
+
+bool colormapFromString(const char *name, ColormapKind &kind) {
+	for (int i = 0; i < 3; ++i)
+		if (strcmp(name, COLORMAPS[i]) == 0) {
+			kind = ColormapKind(i);
+			return true;
+		}
+	return false;
+}
+
+const char *colormapName(ColormapKind kind) {
+	return COLORMAPS[int(kind)];
+}
+
+Colormap::Colormap(ColormapKind kind) : mapKind(kind) {
+	for (int k = 0; k < SIZE; ++k) {
+		float t = float(k) / (SIZE - 1), rgb[3];
+		if (kind == ColormapKind::Viridis)
+			polynomial(VIRIDIS, t, rgb);
+		else if (kind == ColormapKind::Turbo)
+			polynomial(TURBO, t, rgb);
+		else
+			ramp(t, rgb);
+		for (int ch = 0; ch < 3; ++ch)
+			table[3 * k + ch] = (unsigned char)(std::min(std::max(rgb[ch], 0.0f), 1.0f) * 255.0f + 0.5f);
+	}
+}
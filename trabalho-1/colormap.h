@@ -0,0 +1,38 @@
+#ifndef COLORMAP_H
+#define COLORMAP_H
+
+enum class ColormapKind {
+	Ramp,    // rampa original: azul, ciano, verde, amarelo, vermelho
+	Viridis, // perceptualmente uniforme, legível em tons de cinza
+	Turbo,   // arco-íris melhorado, mais contraste que a rampa
+};
+
+// converte "ramp", "viridis" ou "turbo"
+bool colormapFromString(const char *name, ColormapKind &kind);
+const char *colormapName(ColormapKind kind);
+
+// Tabela de SIZE cores RGB calculada uma vez por mapa. O modo imediato
+// consulta a tabela por vértice; o modo retido a envia como textura 1D
+// (MeshRenderer::setColormap) e a cor sai da coordenada de textura.
+class Colormap {
+public:
+	static const int SIZE = 256;
+
+	explicit Colormap(ColormapKind kind = ColormapKind::Ramp);
+
+	ColormapKind kind() const { return mapKind; }
+	// entrada da tabela para t em [0,1]; fora da faixa satura
+	static int index(float t) {
+		int k = int(t * (SIZE - 1) + 0.5f);
+		return k < 0 ? 0 : k >= SIZE ? SIZE - 1 : k;
+	}
+	const unsigned char *color(int index) const { return &table[3 * index]; }
+	// SIZE trincas RGB consecutivas
+	const unsigned char *data() const { return table; }
+
+private:
+	ColormapKind mapKind;
+	unsigned char table[3 * SIZE];
+};
+
+#endif
@@ -0,0 +1,230 @@
+#include "contour.h"
+#include <algorithm>
+#include <cstdio>
+#include <utility>
+
+namespace {
+
+// Segmentos por caso (bit k ligado se o canto k tem u >= L). Cantos 0..3:
+// (i,j), (i+1,j), (i+1,j+1), (i,j+1); arestas 0..3: embaixo, à direita, em
+// cima, à esquerda. As selas (5 e 10) estão com o centro abaixo de L; com o
+// centro acima, usam a linha de SADDLE_HIGH.
+const signed char CASES[16][4] = {
+    {-1, -1, -1, -1}, {3, 0, -1, -1}, {0, 1, -1, -1}, {3, 1, -1, -1}, {1, 2, -1, -1}, {3, 0, 1, 2},
+    {0, 2, -1, -1},   {3, 2, -1, -1}, {2, 3, -1, -1}, {0, 2, -1, -1}, {0, 1, 2, 3},   {1, 2, -1, -1},
+    {1, 3, -1, -1},   {0, 1, -1, -1}, {3, 0, -1, -1}, {-1, -1, -1, -1}};
+const signed char SADDLE_HIGH[2][4] = {{0, 1, 2, 3}, {3, 0, 1, 2}}; // casos 5 e 10
+
+} // namespace
+
+void Contours::setField(const PoissonGrid &g) {
+	grid = &g;
+	n = g.N();
+	m = g.M();
+	blocksX = (n + BLOCK - 1) / BLOCK;
+	blocksY = (m + BLOCK - 1) / BLOCK;
+	blocks.resize(size_t(blocksX) * blocksY);
+	const float *u = g.field().data();
+	const size_t S = n + 1;
+#pragma omp parallel for schedule(static)
+	for (int by = 0; by < blocksY; ++by)
+		for (int bx = 0; bx < blocksX; ++bx) {
+			// nós do bloco, inclusive a última linha e coluna, que ele
+			// divide com os vizinhos
+			const int i0 = bx * BLOCK, i1 = std::min(i0 + BLOCK, n);
+			const int j0 = by * BLOCK, j1 = std::min(j0 + BLOCK, m);
+			float lo = u[i0 + j0 * S], hi = lo;
+			for (int j = j0; j <= j1; ++j)
+				for (int i = i0; i <= i1; ++i) {
+					float v = u[i + j * S];
+					lo = v < lo ? v : lo;
+					hi = v > hi ? v : hi;
+				}
+			blocks[bx + size_t(by) * blocksX] = {lo, hi};
+		}
+}
+
+void Contours::extractBlockRow(int by, std::vector<std::vector<Segment>> &perLevel) const {
+	const float *u = grid->field().data();
+	const size_t S = n + 1;
+	const float hx = grid->h(), ky = grid->k();
+	const float *L = sortedLevels.data();
+	const int levelCount = int(sortedLevels.size());
+	const int j0 = by * BLOCK, j1 = std::min(j0 + BLOCK, m);
+
+	for (int bx = 0; bx < blocksX; ++bx) {
+		// níveis L com min < L <= max cruzam alguma célula do bloco (e a
+		// célula, do mesmo jeito, com os extremos dos seus cantos)
+		const Range &r = blocks[bx + size_t(by) * blocksX];
+		const int k0 = int(std::upper_bound(L, L + levelCount, r.min) - L);
+		const int k1 = int(std::upper_bound(L + k0, L + levelCount, r.max) - L);
+		if (k0 == k1)
+			continue;
+		const int i0 = bx * BLOCK, i1 = std::min(i0 + BLOCK, n);
+		for (int j = j0; j < j1; ++j)
+			for (int i = i0; i < i1; ++i) {
+				const size_t k = i + j * S;
+				const float v[4] = {u[k], u[k + 1], u[k + 1 + S], u[k + S]};
+				const float lo = std::min(std::min(v[0], v[1]), std::min(v[2], v[3]));
+				const float hi = std::max(std::max(v[0], v[1]), std::max(v[2], v[3]));
+				// poucos níveis por bloco: busca linear dentro de [k0, k1)
+				int c0 = k0;
+				while (c0 < k1 && L[c0] <= lo)
+					++c0;
+				int c1 = c0;
+				while (c1 < k1 && L[c1] <= hi)
+					++c1;
+				if (c0 == c1)
+					continue;
+				// arestas: nós das pontas e identificador (2 nó + 0 horizontal, 1 vertical)
+				const size_t ends[4][2] = {{k, k + 1}, {k + 1, k + 1 + S}, {k + S, k + 1 + S}, {k, k + S}};
+				const long long base = 2LL * (long long)k;
+				const long long id[4] = {base, base + 3, base + 2 * (long long)S, base + 1};
+				for (int l = c0; l < c1; ++l) {
+					const float level = L[l];
+					int index = (v[0] >= level) | (v[1] >= level) << 1 | (v[2] >= level) << 2 | (v[3] >= level) << 3;
+					const signed char *e = CASES[index];
+					if ((index == 5 || index == 10) && (v[0] + v[1] + v[2] + v[3]) * 0.25f >= level)
+						e = SADDLE_HIGH[index == 10];
+					for (int s = 0; s < 4 && e[s] >= 0; s += 2) {
+						Segment seg;
+						for (int p = 0; p < 2; ++p) {
+							const int edge = e[s + p];
+							// interpola sempre do nó de menor índice, para os dois
+							// lados da aresta darem o mesmo ponto
+							const size_t a = ends[edge][0], b = ends[edge][1];
+							const float t = (level - u[a]) / (u[b] - u[a]);
+							const int ia = int(a % S), ja = int(a / S);
+							const bool horizontal = b == a + 1;
+							seg.edge[p] = id[edge];
+							seg.p[p][0] = (ia + (horizontal ? t : 0.0f)) * hx;
+							seg.p[p][1] = (ja + (horizontal ? 0.0f : t)) * ky;
+						}
+						perLevel[l].push_back(seg);
+					}
+				}
+			}
+	}
+}
+
+void Contours::stitch(int level, const std::vector<Segment> &segs, std::vector<float> &out,
+                      std::vector<Polyline> &outLines) const {
+	// pontas com a mesma aresta são o mesmo ponto; partner[2s + p] é a ponta
+	// ligada à ponta p do segmento s, ou -1
+	const int count = int(segs.size());
+	std::vector<std::pair<long long, int>> keys(2 * size_t(count));
+	for (int s = 0; s < count; ++s)
+		for (int p = 0; p < 2; ++p)
+			keys[2 * s + p] = {segs[s].edge[p], 2 * s + p};
+	std::sort(keys.begin(), keys.end());
+	std::vector<int> partner(keys.size(), -1);
+	for (size_t k = 0; k + 1 < keys.size(); ++k)
+		if (keys[k].first == keys[k + 1].first) {
+			partner[keys[k].second] = keys[k + 1].second;
+			partner[keys[k + 1].second] = keys[k].second;
+			++k;
+		}
+
+	const float L = sortedLevels[level];
+	std::vector<char> used(count, 0);
+	auto emit = [&](int end) {
+		const float *p = segs[end / 2].p[end % 2];
+		out.insert(out.end(), {p[0], L, p[1]});
+	};
+	// segue a cadeia a partir da ponta `start`; devolve o número de pontos
+	auto walk = [&](int start) {
+		int points = 1, end = start;
+		emit(end);
+		while (true) {
+			used[end / 2] = 1;
+			end ^= 1; // outra ponta do mesmo segmento
+			int next = partner[end];
+			if (next >= 0 && used[next / 2])
+				break; // voltou ao começo: fechada
+			emit(end);
+			++points;
+			if (next < 0)
+				break;
+			end = next;
+		}
+		return points;
+	};
+	// primeiro as abertas, a partir das pontas soltas; o que sobra são laços
+	for (int pass = 0; pass < 2; ++pass)
+		for (int end = 0; end < 2 * count; ++end) {
+			if (used[end / 2] || (pass == 0 && partner[end] >= 0))
+				continue;
+			Polyline line;
+			line.level = level;
+			line.first = int(out.size() / 3);
+			line.count = walk(end);
+			line.closed = pass == 1;
+			outLines.push_back(line);
+		}
+}
+
+void Contours::extract(const std::vector<float> &levels) {
+	sortedLevels = levels;
+	std::sort(sortedLevels.begin(), sortedLevels.end());
+	sortedLevels.erase(std::unique(sortedLevels.begin(), sortedLevels.end()), sortedLevels.end());
+	xyz.clear();
+	lines.clear();
+	segmentCount = 0;
+	const int levelCount = int(sortedLevels.size());
+	if (!grid || levelCount == 0)
+		return;
+
+	// segmentos por linha de blocos e por nível, juntados na ordem da malha
+	std::vector<std::vector<std::vector<Segment>>> rows(blocksY,
+	                                                    std::vector<std::vector<Segment>>(levelCount));
+#pragma omp parallel for schedule(dynamic)
+	for (int by = 0; by < blocksY; ++by)
+		extractBlockRow(by, rows[by]);
+
+	std::vector<std::vector<float>> points(levelCount);
+	std::vector<std::vector<Polyline>> polylines(levelCount);
+	std::vector<long> counts(levelCount);
+#pragma omp parallel for schedule(dynamic)
+	for (int l = 0; l < levelCount; ++l) {
+		std::vector<Segment> segs;
+		for (int by = 0; by < blocksY; ++by) {
+			segs.insert(segs.end(), rows[by][l].begin(), rows[by][l].end());
+			std::vector<Segment>().swap(rows[by][l]);
+		}
+		counts[l] = long(segs.size());
+		stitch(l, segs, points[l], polylines[l]);
+	}
+
+	for (int l = 0; l < levelCount; ++l) {
+		const int offset = int(xyz.size() / 3);
+		xyz.insert(xyz.end(), points[l].begin(), points[l].end());
+		for (Polyline line : polylines[l]) {
+			line.first += offset;
+			lines.push_back(line);
+		}
+		segmentCount += counts[l];
+	}
+}
+
+bool Contours::exportPolylines(const char *path) const {
+	FILE *out = fopen(path, "w");
+	if (!out)
+		return false;
+	for (const Polyline &line : lines) {
+		for (int k = 0; k <= line.count; ++k) {
+			if (k == line.count && !line.closed)
+				break;
+			const float *p = &xyz[3 * size_t(line.first + k % line.count)];
+			fprintf(out, "%g %g %.9g\n", p[0], p[2], p[1]);
+		}
+		fprintf(out, "\n");
+	}
+	return fclose(out) == 0;
+}
+
+std::vector<float> Contours::evenLevels(float min, float max, int count) {
+	std::vector<float> levels;
+	for (int k = 0; k < count; ++k)
+		levels.push_back(min + (max - min) * (k + 1) / (count + 1));
+	return levels;
+}
@@ -0,0 +1,76 @@
+#ifndef CONTOUR_H
+#define CONTOUR_H
+
+#include "grid.h"
+#include <vector>
+
+// Curvas de nível u = L do campo de PoissonGrid por marching squares. Cada
+// célula classifica os quatro cantos (u >= L ou não) e, se a curva passa
+// por ela, dá um ou dois segmentos entre pontos interpolados nas arestas;
+// nas selas, o valor no centro da célula escolhe a ligação.
+//
+// Todos os níveis saem numa passada só. Cada bloco de BLOCK x BLOCK células
+// acha por busca binária, na lista ordenada, o trecho de níveis dentro da sua
+// faixa (mínimo, máximo], e blocos sem nenhum são pulados inteiros. Dentro do
+// bloco, cada célula percorre esse trecho em ordem (busca linear, poucos
+// níveis) até os de (mínimo, máximo] dos seus cantos, e só eles são tratados.
+// As faixas dos blocos ficam guardadas entre chamadas, então trocar só os
+// níveis não relê o campo todo. As linhas de blocos são divididas entre as
+// threads do OpenMP.
+//
+// Os segmentos de um nível são emendados em polilinhas pelos pontos em
+// comum, identificados pela aresta da malha em que estão: cada ponto está
+// em no máximo duas células, então cada polilinha é aberta (começa e
+// termina no contorno do domínio) ou fechada. O resultado não depende do
+// número de threads.
+class Contours {
+public:
+	static const int BLOCK = 16;
+
+	struct Polyline {
+		int level; // índice em levels()
+		int first, count; // pontos em points()
+		bool closed;
+	};
+
+	// Campo a usar nas próximas chamadas de extract; refaz as faixas dos
+	// blocos. Chamar de novo sempre que o campo ou a malha mudarem.
+	void setField(const PoissonGrid &g);
+	// extrai as curvas dos níveis dados (qualquer ordem)
+	void extract(const std::vector<float> &levels);
+
+	const std::vector<float> &levels() const { return sortedLevels; }
+	// pontos (x, u, y), na ordem das polilinhas
+	const std::vector<float> &points() const { return xyz; }
+	const std::vector<Polyline> &polylines() const { return lines; }
+	long segments() const { return segmentCount; }
+
+	// grava as polilinhas como "x y u", com uma linha em branco entre elas
+	// (as fechadas repetem o primeiro ponto), no formato do splot do gnuplot
+	bool exportPolylines(const char *path) const;
+
+	// `count` níveis igualmente espaçados dentro de (min, max)
+	static std::vector<float> evenLevels(float min, float max, int count);
+
+private:
+	struct Segment {
+		long long edge[2]; // arestas da malha dos dois pontos
+		float p[2][2]; // pontos (x, y)
+	};
+	struct Range {
+		float min, max;
+	};
+	void extractBlockRow(int by, std::vector<std::vector<Segment>> &perLevel) const;
+	void stitch(int level, const std::vector<Segment> &segs, std::vector<float> &out,
+	            std::vector<Polyline> &outLines) const;
+
+	const PoissonGrid *grid = nullptr;
+	int n = 0, m = 0, blocksX = 0, blocksY = 0;
+	std::vector<Range> blocks;
+	std::vector<float> sortedLevels;
+	std::vector<float> xyz;
+	std::vector<Polyline> lines;
+	long segmentCount = 0;
+};
+
+#endif
@@ -0,0 +1,236 @@
+#include "dst.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <omp.h>
+
+DstPlan::DstPlan(int n_) : n(n_), L(2 * (n_ + 1)) {
+	// raiz 4 primeiro (borboleta mais barata), depois os primos em ordem
+	int rest = L;
+	while (rest % 4 == 0) {
+		factors.push_back(4);
+		rest /= 4;
+	}
+	for (int p = 2; rest > 1; ++p)
+		while (rest % p == 0) {
+			factors.push_back(p);
+			rest /= p;
+		}
+	cosTable.resize(L);
+	sinTable.resize(L);
+	for (int t = 0; t < L; ++t) {
+		cosTable[t] = std::cos(2.0 * M_PI * t / L);
+		sinTable[t] = std::sin(2.0 * M_PI * t / L);
+	}
+}
+
+// FFT de Stockham (sem reordenação de bits) sobre LANES sequências ao mesmo
+// tempo; o elemento e da sequência b fica em [e*LANES + b]. O resultado volta
+// em (re, im).
+void DstPlan::fft(double *re, double *im, double *tre, double *tim) const {
+	const int B = LANES;
+	double *xr = re, *xi = im, *yr = tre, *yi = tim;
+	int len = L, s = 1;
+	for (int p : factors) {
+		const int m = len / p;
+		const int step = L / len; // w_len^t = tabela[t*step]
+		const int root = L / p; // w_p^t = tabela[t*root]
+		for (int q = 0; q < m; ++q)
+			for (int s0 = 0; s0 < s; ++s0) {
+				const double *ar = xr + size_t(s0 + s * q) * B, *ai = xi + size_t(s0 + s * q) * B;
+				double *br = yr + size_t(s0 + s * p * q) * B, *bi = yi + size_t(s0 + s * p * q) * B;
+				const size_t in = size_t(s) * m * B, out = size_t(s) * B; // distância entre a_t e entre y_u
+				if (p == 2) {
+					const double wr = cosTable[q * step], wi = -sinTable[q * step];
+					for (int b = 0; b < B; ++b) {
+						double r0 = ar[b], i0 = ai[b], r1 = ar[in + b], i1 = ai[in + b];
+						double dr = r0 - r1, di = i0 - i1;
+						br[b] = r0 + r1;
+						bi[b] = i0 + i1;
+						br[out + b] = dr * wr - di * wi;
+						bi[out + b] = dr * wi + di * wr;
+					}
+				} else if (p == 4) {
+					double wr[4], wi[4];
+					for (int u = 1; u < 4; ++u) {
+						wr[u] = cosTable[q * u * step];
+						wi[u] = -sinTable[q * u * step];
+					}
+					for (int b = 0; b < B; ++b) {
+						double r0 = ar[b], i0 = ai[b], r1 = ar[in + b], i1 = ai[in + b];
+						double r2 = ar[2 * in + b], i2 = ai[2 * in + b], r3 = ar[3 * in + b], i3 = ai[3 * in + b];
+						double s0r = r0 + r2, s0i = i0 + i2, d0r = r0 - r2, d0i = i0 - i2;
+						double s1r = r1 + r3, s1i = i1 + i3;
+						// (a1 - a3) * (-i)
+						double d1r = i1 - i3, d1i = r3 - r1;
+						br[b] = s0r + s1r;
+						bi[b] = s0i + s1i;
+						double yr1 = d0r + d1r, yi1 = d0i + d1i;
+						double yr2 = s0r - s1r, yi2 = s0i - s1i;
+						double yr3 = d0r - d1r, yi3 = d0i - d1i;
+						br[out + b] = yr1 * wr[1] - yi1 * wi[1];
+						bi[out + b] = yr1 * wi[1] + yi1 * wr[1];
+						br[2 * out + b] = yr2 * wr[2] - yi2 * wi[2];
+						bi[2 * out + b] = yr2 * wi[2] + yi2 * wr[2];
+						br[3 * out + b] = yr3 * wr[3] - yi3 * wi[3];
+						bi[3 * out + b] = yr3 * wi[3] + yi3 * wr[3];
+					}
+				} else {
+					// DFT direta de tamanho p
+					for (int u = 0; u < p; ++u) {
+						double accr[B], acci[B];
+						for (int b = 0; b < B; ++b)
+							accr[b] = acci[b] = 0.0;
+						for (int t = 0; t < p; ++t) {
+							const int e = (t * u) % p * root;
+							const double cr = cosTable[e], ci = -sinTable[e];
+							const double *tr = ar + t * in, *ti = ai + t * in;
+							for (int b = 0; b < B; ++b) {
+								accr[b] += tr[b] * cr - ti[b] * ci;
+								acci[b] += tr[b] * ci + ti[b] * cr;
+							}
+						}
+						const double wr = cosTable[q * u * step], wi = -sinTable[q * u * step];
+						for (int b = 0; b < B; ++b) {
+							br[u * out + b] = accr[b] * wr - acci[b] * wi;
+							bi[u * out + b] = accr[b] * wi + acci[b] * wr;
+						}
+					}
+				}
+			}
+		std::swap(xr, yr);
+		std::swap(xi, yi);
+		len = m;
+		s *= p;
+	}
+	if (xr != re) {
+		std::memcpy(re, xr, sizeof(double) * L * B);
+		std::memcpy(im, xi, sizeof(double) * L * B);
+	}
+}
+
+void DstPlan::transform(double *data, int count, std::ptrdiff_t stride, std::vector<double> &scratch) const {
+	const int B = LANES;
+	scratch.resize(4 * size_t(L) * B);
+	double *re = scratch.data(), *im = re + size_t(L) * B, *tre = im + size_t(L) * B, *tim = tre + size_t(L) * B;
+
+	for (int r0 = 0; r0 < count; r0 += 2 * B) {
+		// extensão ímpar [0, x, 0, -x invertido]: o vetor r0+b vai na parte
+		// real da sequência b e o vetor r0+B+b na imaginária
+		std::fill(re, re + size_t(L) * B, 0.0);
+		std::fill(im, im + size_t(L) * B, 0.0);
+		for (int b = 0; b < 2 * B && r0 + b < count; ++b) {
+			const double *x = data + (r0 + b) * stride;
+			double *dst = b < B ? re : im;
+			const int lane = b % B;
+			for (int i = 1; i <= n; ++i) {
+				dst[size_t(i) * B + lane] = x[i - 1];
+				dst[size_t(L - i) * B + lane] = -x[i - 1];
+			}
+		}
+		fft(re, im, tre, tim);
+		// FFT(y_a + i y_b) = -2i S_a + 2 S_b
+		for (int b = 0; b < 2 * B && r0 + b < count; ++b) {
+			double *x = data + (r0 + b) * stride;
+			const int lane = b % B;
+			if (b < B)
+				for (int k = 1; k <= n; ++k)
+					x[k - 1] = -0.5 * im[size_t(k) * B + lane];
+			else
+				for (int k = 1; k <= n; ++k)
+					x[k - 1] = 0.5 * re[size_t(k) * B + lane];
+		}
+	}
+}
+
+SolverStats solveDST(int N, int M, float *solution, const SolverOptions &opt) {
+	auto t0 = std::chrono::steady_clock::now();
+
+	const int nx = N - 1, ny = M - 1;
+	const double cx = N * N / (X_MAX * X_MAX), cy = M * M / (Y_MAX * Y_MAX);
+	const size_t n = size_t(nx) * ny;
+	const int threads = opt.threads > 0 ? opt.threads : omp_get_max_threads();
+
+	std::vector<double> g(n), u(n);
+	poissonRHS(N, M, g.data());
+
+	SolverStats st;
+	// sem iterados para mostrar, o cancelamento é visto entre os lotes das
+	// transformadas e entre as etapas
+	auto stopRequested = [&] { return opt.monitor && opt.monitor->cancelled(); };
+	auto cancelled = [&] {
+		if (!stopRequested())
+			return false;
+		st.cancelled = true;
+		st.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+		return true;
+	};
+
+	DstPlan plan(nx);
+	const int batch = 2 * DstPlan::LANES;
+	auto transformRows = [&](double *data) {
+#pragma omp parallel num_threads(threads)
+		{
+			std::vector<double> scratch;
+#pragma omp for schedule(static)
+			for (int r0 = 0; r0 < ny; r0 += batch)
+				if (!stopRequested())
+					plan.transform(data + size_t(r0) * nx, std::min(batch, ny - r0), nx, scratch);
+		}
+	};
+
+	u = g;
+	transformRows(u.data());
+	if (cancelled())
+		return st;
+
+	// Modo k: cy û[j-1] + (λk - 2cy) û[j] + cy û[j+1] = ĝ[j], com
+	// λk = -4 cx sin²(pi k / 2N). Thomas em j, com k no laço interno.
+	std::vector<double> diag(nx), cp(n);
+	for (int k = 0; k < nx; ++k) {
+		double sk = std::sin(M_PI * (k + 1) / (2.0 * N));
+		diag[k] = -4.0 * cx * sk * sk - 2.0 * cy;
+	}
+	const int chunk = 256;
+#pragma omp parallel for num_threads(threads) schedule(static)
+	for (int k0 = 0; k0 < nx; k0 += chunk) {
+		if (stopRequested())
+			continue;
+		const int k1 = std::min(nx, k0 + chunk);
+		for (int j = 0; j < ny; ++j) {
+			double *uj = &u[size_t(j) * nx], *cj = &cp[size_t(j) * nx];
+			const double *uprev = j > 0 ? uj - nx : nullptr, *cprev = j > 0 ? cj - nx : nullptr;
+			for (int k = k0; k < k1; ++k) {
+				double den = diag[k] - (j > 0 ? cy * cprev[k] : 0.0);
+				cj[k] = cy / den;
+				uj[k] = (uj[k] - (j > 0 ? cy * uprev[k] : 0.0)) / den;
+			}
+		}
+		for (int j = ny - 2; j >= 0; --j) {
+			double *uj = &u[size_t(j) * nx];
+			const double *cj = &cp[size_t(j) * nx], *unext = uj + nx;
+			for (int k = k0; k < k1; ++k)
+				uj[k] -= cj[k] * unext[k];
+		}
+	}
+
+	if (cancelled())
+		return st;
+	transformRows(u.data());
+	// a transformada inversa pula os lotes restantes ao receber o pedido:
+	// u pode estar pela metade e não vai para a solução
+	if (cancelled())
+		return st;
+	const double scale = 2.0 / N;
+	for (double &v : u)
+		v *= scale;
+
+	for (size_t k = 0; k < n; ++k)
+		solution[k] = float(u[k]);
+
+	// resíduo de verificação, na mesma medida relativa dos solvers iterativos
+	st.residual = relativeResidual(N, M, u.data(), g.data());
+	st.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+	return st;
+}
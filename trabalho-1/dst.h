@@ -0,0 +1,42 @@
+#ifndef DST_H
+#define DST_H
+
+#include "poisson.h"
+#include <cstddef>
+#include <vector>
+
+// Transformada seno discreta do tipo I, sem normalização:
+//   X[k] = soma_{i=1..n} x[i] sin(pi i k / (n+1)),  k = 1..n
+// (aplicada duas vezes dá (n+1)/2 vezes o vetor original).
+// É calculada por uma FFT complexa de raiz mista de tamanho 2(n+1) sobre a
+// extensão ímpar do vetor. Como a FFT de uma sequência real ímpar é puramente
+// imaginária, cada transformada complexa leva dois vetores, um na parte real e
+// outro na imaginária. Os vetores são processados em lotes, com o índice do
+// vetor dentro do lote na dimensão mais interna: cada borboleta opera sobre
+// LANES valores contíguos, e o compilador vetoriza esses laços.
+class DstPlan {
+public:
+	static const int LANES = 8; // transformadas complexas por lote (2*LANES vetores)
+
+	explicit DstPlan(int n);
+
+	int size() const { return n; }
+	// Transforma `count` vetores de comprimento n, o r-ésimo em data + r*stride.
+	// `scratch` é redimensionado conforme preciso e pode ser reaproveitado.
+	void transform(double *data, int count, std::ptrdiff_t stride, std::vector<double> &scratch) const;
+
+private:
+	void fft(double *re, double *im, double *tre, double *tim) const;
+
+	int n, L; // L = 2(n+1), tamanho da FFT
+	std::vector<int> factors; // raízes das etapas da FFT
+	std::vector<double> cosTable, sinTable; // e^{-2 pi i t / L} = cos - i sin
+};
+
+// Solver direto: DST em x, um sistema tridiagonal em y por modo de Fourier e
+// DST inversa, em O(N M log N), sem iterações. Os valores de contorno entram
+// no lado direito. Tamanhos 2N com fatores primos grandes deixam a FFT mais
+// lenta (a borboleta de raiz p genérica custa O(p)), mas ainda corretos.
+SolverStats solveDST(int N, int M, float *solution, const SolverOptions &opt);
+
+#endif
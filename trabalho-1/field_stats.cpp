@@ -0,0 +1,90 @@
+#include "field_stats.h"
+#include <algorithm>
+#include <cstddef>
+
+void FieldStats::compute(int N, int M, const float *field) {
+	n = N;
+	m = M;
+	rows.assign(M + 1, Row{0.0f, 0.0f, 0.0});
+	rowHist.assign(size_t(M + 1) * BINS, 0);
+	hist.assign(BINS, 0);
+	count = double(N + 1) * (M + 1);
+	update(field, 0, M);
+}
+
+void FieldStats::update(const float *field, int j0, int j1) {
+	j0 = std::max(j0, 0);
+	j1 = std::min(j1, m);
+	if (j0 > j1)
+		return;
+	// tira a contribuição antiga das linhas que mudaram
+	for (int j = j0; j <= j1; ++j)
+		for (int b = 0; b < BINS; ++b)
+			hist[b] -= rowHist[size_t(j) * BINS + b];
+	scan(field, j0, j1);
+	for (int j = j0; j <= j1; ++j)
+		for (int b = 0; b < BINS; ++b)
+			hist[b] += rowHist[size_t(j) * BINS + b];
+	combine();
+	if (rangeStale())
+		rebuildHistogram(field);
+}
+
+void FieldStats::scan(const float *field, int j0, int j1) {
+	const int s = n + 1;
+	const float scale = hi > lo ? BINS / (hi - lo) : 0.0f;
+#pragma omp parallel for schedule(static)
+	for (int j = j0; j <= j1; ++j) {
+		const float *u = field + size_t(j) * s;
+		float a = u[0], b = u[0];
+		double t = 0.0;
+#pragma omp simd reduction(min : a) reduction(max : b) reduction(+ : t)
+		for (int i = 0; i < s; ++i) {
+			a = u[i] < a ? u[i] : a;
+			b = u[i] > b ? u[i] : b;
+			t += u[i];
+		}
+		rows[j] = Row{a, b, t};
+		// Quatro histogramas intercalados: num campo suave, nós vizinhos caem
+		// na mesma faixa, e com um só contador cada incremento esperaria o
+		// anterior sair da memória.
+		unsigned part[4][BINS] = {};
+		auto bin = [&](float v) { return std::min(std::max(int((v - lo) * scale), 0), BINS - 1); };
+		int i = 0;
+		for (; i + 4 <= s; i += 4) {
+			++part[0][bin(u[i])];
+			++part[1][bin(u[i + 1])];
+			++part[2][bin(u[i + 2])];
+			++part[3][bin(u[i + 3])];
+		}
+		for (; i < s; ++i)
+			++part[0][bin(u[i])];
+		unsigned *h = &rowHist[size_t(j) * BINS];
+		for (int b = 0; b < BINS; ++b)
+			h[b] = part[0][b] + part[1][b] + part[2][b] + part[3][b];
+	}
+}
+
+void FieldStats::combine() {
+	minValue = rows[0].min;
+	maxValue = rows[0].max;
+	sum = 0.0;
+	for (const Row &r : rows) {
+		minValue = std::min(minValue, r.min);
+		maxValue = std::max(maxValue, r.max);
+		sum += r.sum;
+	}
+}
+
+bool FieldStats::rangeStale() const {
+	return minValue < lo || maxValue > hi || hi - lo > 2.0f * (maxValue - minValue);
+}
+
+void FieldStats::rebuildHistogram(const float *field) {
+	lo = minValue;
+	hi = maxValue;
+	scan(field, 0, m);
+	std::fill(hist.begin(), hist.end(), 0u);
+	for (size_t k = 0; k < rowHist.size(); ++k)
+		hist[k % BINS] += rowHist[k];
+}
@@ -0,0 +1,55 @@
+#ifndef FIELD_STATS_H
+#define FIELD_STATS_H
+
+#include <vector>
+
+// Mínimo, máximo, média e histograma do campo completo (N+1)x(M+1) de
+// PoissonGrid. O resumo é guardado por linha (extremos, soma e histograma da
+// linha), então quando só algumas linhas mudam basta relê-las e recombinar.
+// Cada linha é lida uma vez: os extremos e a soma saem de um laço SIMD e o
+// histograma de um segundo laço sobre a mesma linha, ainda no cache; as
+// linhas são divididas entre as threads do OpenMP.
+//
+// O histograma usa a faixa [histogramMin(), histogramMax()] da última
+// reconstrução. Se os extremos saem dessa faixa, ou ela fica com mais que o
+// dobro da largura necessária, todos os histogramas de linha são refeitos
+// numa segunda passada; com a faixa estável, como nos iterados de um solve,
+// cada atualização é uma passada só.
+class FieldStats {
+public:
+	static const int BINS = 64;
+
+	// recalcula tudo para o campo da malha N x M
+	void compute(int N, int M, const float *field);
+	// só as linhas j0..j1 (inclusive) mudaram desde o último compute/update
+	void update(const float *field, int j0, int j1);
+
+	float min() const { return minValue; }
+	float max() const { return maxValue; }
+	double mean() const { return count ? sum / count : 0.0; }
+	// BINS contagens de largura igual em [histogramMin(), histogramMax()]
+	const std::vector<unsigned> &histogram() const { return hist; }
+	float histogramMin() const { return lo; }
+	float histogramMax() const { return hi; }
+
+private:
+	struct Row {
+		float min, max;
+		double sum;
+	};
+	void scan(const float *field, int j0, int j1);
+	void combine();
+	bool rangeStale() const;
+	void rebuildHistogram(const float *field);
+
+	int n = 0, m = 0;
+	std::vector<Row> rows;
+	std::vector<unsigned> rowHist; // BINS contagens por linha
+	std::vector<unsigned> hist;
+	float lo = 0.0f, hi = 0.0f; // faixa do histograma
+	float minValue = 0.0f, maxValue = 0.0f;
+	double sum = 0.0;
+	double count = 0.0;
+};
+
+#endif
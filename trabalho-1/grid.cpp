@@ -0,0 +1,88 @@
+#include "grid.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+void PoissonGrid::resize(int N, int M) {
+	N = std::max(N, 2);
+	M = std::max(M, 2);
+	std::vector<float> next(size_t(N + 1) * (M + 1), 0.0f);
+	setFieldBoundary(N, M, next.data());
+	hasGuess = hasSolution || hasGuess;
+	if (hasGuess)
+		interpolateField(n, m, values.data(), N, M, next.data());
+	values.swap(next);
+	n = N;
+	m = M;
+	hx = float(X_MAX) / float(n);
+	ky = float(Y_MAX) / float(m);
+	hasSolution = false;
+	valueStats.compute(n, m, values.data());
+}
+
+SolverStats PoissonGrid::solve(const SolverOptions &opt) {
+	SolverOptions o = opt;
+	o.warmStart = warmStart && hasGuess;
+	std::vector<float> u = solution();
+	lastStats = solvePoisson(n, m, u.data(), o);
+	storeInterior(u.data());
+	hasSolution = true;
+	hasGuess = false;
+	return lastStats;
+}
+
+std::vector<float> PoissonGrid::solution() const {
+	std::vector<float> u(size_t(n - 1) * (m - 1));
+	getFieldInterior(n, m, values.data(), u.data());
+	return u;
+}
+
+void PoissonGrid::setIterate(const std::vector<float> &u) {
+	if (u.size() != size_t(n - 1) * (m - 1))
+		return;
+	storeInterior(u.data());
+	hasGuess = true;
+}
+
+void PoissonGrid::setSolution(const std::vector<float> &u, const SolverStats &stats) {
+	if (u.size() != size_t(n - 1) * (m - 1))
+		return;
+	storeInterior(u.data());
+	lastStats = stats;
+	hasSolution = true;
+	hasGuess = false;
+}
+
+void PoissonGrid::storeInterior(const float *u) {
+	setFieldInterior(n, m, u, values.data());
+	// as linhas 0 e m são contorno e não mudam
+	valueStats.update(values.data(), 1, m - 1);
+}
+
+void PoissonGrid::normal(int i, int j, float &nx, float &ny, float &nz) const {
+	const int il = std::max(i - 1, 0), ir = std::min(i + 1, n);
+	const int jl = std::max(j - 1, 0), jr = std::min(j + 1, m);
+	const float ux = (value(ir, j) - value(il, j)) / ((ir - il) * hx);
+	const float uy = (value(i, jr) - value(i, jl)) / ((jr - jl) * ky);
+	// (1, ux, 0) x (0, uy, 1) com o sinal trocado, para cima
+	const float s = 1.0f / std::sqrt(ux * ux + 1.0f + uy * uy);
+	nx = -ux * s;
+	ny = s;
+	nz = -uy * s;
+}
+
+float PoissonGrid::maxAbsValue() const {
+	return std::max(std::fabs(valueStats.min()), std::fabs(valueStats.max()));
+}
+
+bool PoissonGrid::exportField(const char *path) const {
+	FILE *out = fopen(path, "w");
+	if (!out)
+		return false;
+	for (int j = 0; j <= m; ++j) {
+		for (int i = 0; i <= n; ++i)
+			fprintf(out, "%g %g %.9g\n", i * hx, j * ky, value(i, j));
+		fprintf(out, "\n");
+	}
+	return fclose(out) == 0;
+}
@@ -0,0 +1,75 @@
+#ifndef GRID_H
+#define GRID_H
+
+#include "field_stats.h"
+#include "poisson.h"
+#include <cstddef>
+#include <vector>
+
+// Malha N x M do problema e a solução calculada nela. Substitui as antigas
+// constantes globais N, M, h e k de main.cpp, para a resolução poder mudar
+// em tempo de execução.
+class PoissonGrid {
+public:
+	PoissonGrid(int N = 50, int M = 25) { resize(N, M); }
+
+	// Muda a resolução. Se já havia solução (ou um iterado), ela é interpolada
+	// na malha nova e vira o chute inicial do próximo solve() (partida a quente).
+	void resize(int N, int M);
+	// resolve; usa o chute interpolado se houver e a partida a quente estiver ligada
+	SolverStats solve(const SolverOptions &opt);
+	// true se o próximo solve partirá do chute guardado em solution()
+	bool warmStartReady() const { return warmStart && hasGuess; }
+
+	// Resultado de um solve feito fora da malha (solver_thread.h): setIterate
+	// mostra um iterado intermediário, que também serve de chute se a
+	// resolução mudar antes do fim; setSolution guarda a solução final.
+	void setIterate(const std::vector<float> &u);
+	void setSolution(const std::vector<float> &u, const SolverStats &stats);
+
+	void setWarmStart(bool enabled) { warmStart = enabled; }
+	bool warmStartEnabled() const { return warmStart; }
+
+	int N() const { return n; }
+	int M() const { return m; }
+	float h() const { return hx; } // passo em x [0,2]
+	float k() const { return ky; } // passo em y [0,1]
+	bool solved() const { return hasSolution; }
+	const SolverStats &stats() const { return lastStats; }
+	// cópia dos pontos interiores, no layout dos solvers
+	std::vector<float> solution() const;
+	// malha completa com o contorno, field[i + j*(N+1)]
+	const std::vector<float> &field() const { return values; }
+
+	// converte os índices da malha (i,j) para coordenadas (x,y)
+	void getCoordinates(int i, int j, float &x, float &y) const {
+		x = (float)i * hx;
+		y = (float)j * ky;
+	}
+	// valor da solução no nó (i,j), contorno incluído
+	float value(int i, int j) const { return values[i + std::size_t(j) * (n + 1)]; }
+	// normal unitária (nx, ny, nz) da superfície (x, u, y) no nó (i,j), por
+	// diferenças centrais (de um lado só no contorno)
+	void normal(int i, int j, float &nx, float &ny, float &nz) const;
+	// maior |u| na malha
+	float maxAbsValue() const;
+	// mínimo, máximo, média e histograma do campo, mantidos a cada mudança
+	const FieldStats &fieldStats() const { return valueStats; }
+	// grava "x y u" por nó, com uma linha em branco entre as linhas j (formato do splot do gnuplot)
+	bool exportField(const char *path) const;
+
+private:
+	// grava o interior dos solvers no campo e atualiza as estatísticas
+	void storeInterior(const float *u);
+
+	int n = 0, m = 0;
+	float hx = 0.0f, ky = 0.0f;
+	std::vector<float> values; // campo completo, contorno calculado em resize()
+	FieldStats valueStats;
+	bool hasSolution = false;
+	bool hasGuess = false; // o interior tem a solução anterior interpolada
+	bool warmStart = true;
+	SolverStats lastStats;
+};
+
+#endif
@@ -0,0 +1,182 @@
+#include "camera.h"
+#include "colormap.h"
+#include "grid.h"
+#include "raster.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <omp.h>
+#include <string>
+
+// Modo sem janela: resolve o problema e desenha a superfície com o
+// rasterizador de CPU (raster.h), para máquinas sem GPU nem display. A
+// câmera parte da mesma posição do visualizador.
+//
+// uso: ./headless [N M] [mg|pcg|sor|dst|chol] [opções]
+//   -o arquivo   imagem .png ou .ppm (padrão superficie.png)
+//   -s LxA       tamanho da imagem (padrão 3840x2160)
+//   -f quadros   quadros medidos (padrão 10)
+//   -m mapa      ramp, viridis ou turbo
+//   -a graus     azimute; -e graus elevação; -r raio distância ao alvo
+//   -x graus     rotação da malha em X; -y graus rotação em Y
+//   -t threads   threads do OpenMP (padrão todas)
+//   -p precisão  aritmética do multigrid: double (padrão), float ou mixed
+//   -S           mede de 1 thread até todas, como o "scaling" do solver_bench
+//   -L           sem iluminação, só as cores do mapa (tecla n do visualizador)
+
+namespace {
+
+void usage() {
+	fprintf(stderr, "uso: ./headless [N M] [mg|pcg|sor|dst|chol] [-o arquivo] [-s LxA] [-f quadros] [-m mapa]\n"
+	                "                [-a azimute] [-e elevação] [-r raio] [-x graus] [-y graus] [-t threads] [-p precisão]\n"
+	                "                [-S] [-L]\n");
+}
+
+// desenha `frames` quadros e devolve a média dos tempos
+SoftwareRasterizer::Timing measure(SoftwareRasterizer &r, const PoissonGrid &g, const Colormap &cmap,
+                                   const OrbitCamera &camera, bool lighting, int frames) {
+	const FieldStats &fs = g.fieldStats();
+	SoftwareRasterizer::Timing sum;
+	// o primeiro quadro aloca as listas e não entra na média
+	r.drawSurface(g, cmap, fs.min(), fs.max(), camera, lighting);
+	for (int f = 0; f < frames; ++f) {
+		r.drawSurface(g, cmap, fs.min(), fs.max(), camera, lighting);
+		sum.transform += r.timing().transform;
+		sum.setup += r.timing().setup;
+		sum.raster += r.timing().raster;
+	}
+	sum.transform /= frames;
+	sum.setup /= frames;
+	sum.raster /= frames;
+	sum.triangles = r.timing().triangles;
+	return sum;
+}
+
+void report(int threads, const SoftwareRasterizer::Timing &t) {
+	double total = t.transform + t.setup + t.raster;
+	printf("%7d %10.2f %10.2f %10.2f %10.2f %11ld\n", threads, t.transform * 1e3, t.setup * 1e3, t.raster * 1e3,
+	       total * 1e3, t.triangles);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+	int N = 50, M = 25;
+	int arg = 1;
+	if (argc > 2 && atoi(argv[1]) > 0 && atoi(argv[2]) > 0) {
+		N = atoi(argv[1]);
+		M = atoi(argv[2]);
+		arg = 3;
+	}
+	SolverOptions opt;
+	if (argc > arg && argv[arg][0] != '-') {
+		if (!solverFromString(argv[arg], opt.method)) {
+			fprintf(stderr, "Método desconhecido: %s (use mg, pcg, sor, dst ou chol)\n", argv[arg]);
+			return 1;
+		}
+		++arg;
+	}
+
+	std::string output = "superficie.png";
+	int width = 3840, height = 2160, frames = 10, threads = 0;
+	bool scaling = false, lighting = true;
+	OrbitCamera camera;
+	Colormap colormap;
+	for (; arg < argc; ++arg) {
+		const char *o = argv[arg];
+		if (strcmp(o, "-S") == 0) {
+			scaling = true;
+			continue;
+		}
+		if (strcmp(o, "-L") == 0) {
+			lighting = false;
+			continue;
+		}
+		if (arg + 1 >= argc || o[0] != '-' || strlen(o) != 2) {
+			usage();
+			return 1;
+		}
+		const char *v = argv[++arg];
+		switch (o[1]) {
+		case 'o':
+			output = v;
+			break;
+		case 's':
+			if (sscanf(v, "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0) {
+				usage();
+				return 1;
+			}
+			break;
+		case 'f':
+			frames = std::max(1, atoi(v));
+			break;
+		case 'm': {
+			ColormapKind kind;
+			if (!colormapFromString(v, kind)) {
+				fprintf(stderr, "Mapa desconhecido: %s (use ramp, viridis ou turbo)\n", v);
+				return 1;
+			}
+			colormap = Colormap(kind);
+			break;
+		}
+		case 'a':
+			camera.azimuth = float(atof(v));
+			break;
+		case 'e':
+			camera.elevation = float(atof(v));
+			break;
+		case 'r':
+			camera.radius = std::max(0.1f, float(atof(v)));
+			break;
+		case 'x':
+			camera.meshRotX = float(atof(v));
+			break;
+		case 'y':
+			camera.meshRotY = float(atof(v));
+			break;
+		case 't':
+			threads = atoi(v);
+			break;
+		case 'p':
+			if (!precisionFromString(v, opt.precision)) {
+				fprintf(stderr, "Precisão desconhecida: %s (use double, float ou mixed)\n", v);
+				return 1;
+			}
+			break;
+		default:
+			usage();
+			return 1;
+		}
+	}
+	if (threads > 0)
+		omp_set_num_threads(threads);
+
+	PoissonGrid grid(N, M);
+	SolverStats st = grid.solve(opt);
+	printf("Malha %d x %d (%s): %d iterações, resíduo %.2e, %.1f ms\n", grid.N(), grid.M(), solverName(opt.method),
+	       st.iterations, st.residual, st.seconds * 1e3);
+
+	SoftwareRasterizer raster(width, height);
+	printf("Imagem %d x %d, ladrilhos de %d, %d quadros (ms/quadro)\n", width, height, SoftwareRasterizer::TILE,
+	       frames);
+	printf("%7s %10s %10s %10s %10s %11s\n", "threads", "vértices", "montagem", "rasteriz.", "total", "triângulos");
+	if (scaling) {
+		int maxThreads = omp_get_max_threads();
+		for (int t = 1;; t = std::min(2 * t, maxThreads)) {
+			omp_set_num_threads(t);
+			report(t, measure(raster, grid, colormap, camera, lighting, frames));
+			if (t == maxThreads)
+				break;
+		}
+	} else {
+		report(omp_get_max_threads(), measure(raster, grid, colormap, camera, lighting, frames));
+	}
+
+	if (!raster.image().write(output)) {
+		fprintf(stderr, "Não foi possível gravar %s\n", output.c_str());
+		return 1;
+	}
+	printf("Imagem gravada em %s\n", output.c_str());
+	return 0;
+}
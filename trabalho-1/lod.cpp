@@ -0,0 +1,186 @@
+#include "lod.h"
+#include <algorithm>
+#include <cmath>
+
+void SurfaceLod::build(const PoissonGrid &g) {
+	const int N = g.N(), M = g.M();
+	if (N != n || M != m || chunks.empty()) {
+		n = N;
+		m = M;
+		hx = g.h();
+		ky = g.k();
+		chunksX = (N + CHUNK - 1) / CHUNK;
+		chunksY = (M + CHUNK - 1) / CHUNK;
+		chunks.assign(size_t(chunksX) * chunksY, Chunk());
+		for (int cy = 0; cy < chunksY; ++cy)
+			for (int cx = 0; cx < chunksX; ++cx) {
+				Chunk &c = chunks[cx + size_t(cy) * chunksX];
+				c.i0 = cx * CHUNK;
+				c.j0 = cy * CHUNK;
+				c.cw = std::min(CHUNK, N - c.i0);
+				c.ch = std::min(CHUNK, M - c.j0);
+				// o passo precisa dividir o bloco; no nível mais grosso de um
+				// bloco inteiro sobra uma célula, e aí nenhum vizinho pode
+				// ser mais grosso, então a emenda sempre tem um nó de dentro
+				c.maxLevel = 0;
+				while (c.maxLevel < MAX_LEVEL && c.cw % (2 << c.maxLevel) == 0 && c.ch % (2 << c.maxLevel) == 0)
+					++c.maxLevel;
+				c.level = 0;
+			}
+		patterns.clear();
+	}
+	previous.clear();
+
+	const float *u = g.field().data();
+#pragma omp parallel for schedule(dynamic)
+	for (int k = 0; k < int(chunks.size()); ++k)
+		computeErrors(chunks[k], u);
+}
+
+void SurfaceLod::computeErrors(Chunk &c, const float *u) const {
+	const size_t S = n + 1;
+	const float *base = u + c.i0 + c.j0 * S;
+	c.umin = c.umax = base[0];
+	for (int j = 0; j <= c.ch; ++j)
+		for (int i = 0; i <= c.cw; ++i) {
+			c.umin = std::min(c.umin, base[i + j * S]);
+			c.umax = std::max(c.umax, base[i + j * S]);
+		}
+
+	c.error[0] = 0.0f;
+	for (int l = 1; l <= MAX_LEVEL; ++l) {
+		c.error[l] = c.error[l - 1];
+		if (l > c.maxLevel)
+			continue;
+		const int s = 1 << l;
+		const float inv = 1.0f / s;
+		for (int j = 0; j <= c.ch; ++j) {
+			const int b = std::min(j / s, c.ch / s - 1);
+			const float fb = (j - b * s) * inv;
+			for (int i = 0; i <= c.cw; ++i) {
+				const int a = std::min(i / s, c.cw / s - 1);
+				const float fa = (i - a * s) * inv;
+				const float *q = base + a * s + b * s * S;
+				float u00 = q[0], u10 = q[s], u01 = q[s * S], u11 = q[s + s * S];
+				// mesma diagonal do desenho, de (1,0) a (0,1)
+				float v = fa + fb <= 1.0f ? u00 + fa * (u10 - u00) + fb * (u01 - u00)
+				                          : u11 + (1.0f - fa) * (u01 - u11) + (1.0f - fb) * (u10 - u11);
+				c.error[l] = std::max(c.error[l], std::fabs(base[i + j * S] - v));
+			}
+		}
+	}
+}
+
+const std::vector<int> &SurfaceLod::pattern(int cw, int ch, int level, int coarser) {
+	long key = ((long(cw) * 1024 + ch) * (MAX_LEVEL + 1) + level) * 16 + coarser;
+	auto found = patterns.find(key);
+	if (found != patterns.end())
+		return found->second;
+
+	std::vector<int> &out = patterns[key];
+	const int s = 1 << level, a = cw / s, b = ch / s;
+	const int S = n + 1;
+	auto node = [&](int p, int q) { return p * s + q * s * S; };
+	// nós ímpares de um lado com vizinho mais grosso ficam de fora
+	auto dropped = [&](int p, int q) {
+		return ((coarser & 1) && p == 0 && q % 2) || ((coarser & 2) && p == a && q % 2) ||
+		       ((coarser & 4) && q == 0 && p % 2) || ((coarser & 8) && q == b && p % 2);
+	};
+	for (int q = 0; q < b; ++q)
+		for (int p = 0; p < a; ++p) {
+			// cantos na ordem das faixas: (p,q) (p+1,q) (p,q+1) (p+1,q+1)
+			const int corner[4][2] = {{p, q}, {p + 1, q}, {p, q + 1}, {p + 1, q + 1}};
+			int kept[4], count = 0;
+			for (const auto &c : corner)
+				if (!dropped(c[0], c[1]))
+					kept[count++] = node(c[0], c[1]);
+			if (count == 4)
+				out.insert(out.end(), {kept[0], kept[1], kept[2], kept[1], kept[2], kept[3]});
+			else if (count == 3)
+				out.insert(out.end(), {kept[0], kept[1], kept[2]});
+		}
+	// o buraco deixado por cada nó removido é um triângulo entre os dois
+	// vizinhos dele na borda e o nó logo para dentro
+	for (int q = 1; q < b; q += 2) {
+		if (coarser & 1)
+			out.insert(out.end(), {node(0, q - 1), node(0, q + 1), node(1, q)});
+		if (coarser & 2)
+			out.insert(out.end(), {node(a, q - 1), node(a, q + 1), node(a - 1, q)});
+	}
+	for (int p = 1; p < a; p += 2) {
+		if (coarser & 4)
+			out.insert(out.end(), {node(p - 1, 0), node(p + 1, 0), node(p, 1)});
+		if (coarser & 8)
+			out.insert(out.end(), {node(p - 1, b), node(p + 1, b), node(p, b - 1)});
+	}
+	return out;
+}
+
+bool SurfaceLod::select(const OrbitCamera &camera, int viewportHeight, float pixelError) {
+	if (chunks.empty())
+		return false;
+	// pixels por unidade de comprimento a uma unidade de distância
+	const float scale = viewportHeight / (2.0f * std::tan(OrbitCamera::FOVY * float(M_PI / 180.0) / 2.0f));
+	float ex, ey, ez;
+	camera.modelEye(ex, ey, ez);
+
+	for (Chunk &c : chunks) {
+		// distância do olho à caixa do bloco (x, u, y)
+		float dx = std::max({c.i0 * hx - ex, 0.0f, ex - (c.i0 + c.cw) * hx});
+		float dy = std::max({c.umin - ey, 0.0f, ey - c.umax});
+		float dz = std::max({c.j0 * ky - ez, 0.0f, ez - (c.j0 + c.ch) * ky});
+		float allowed = pixelError * std::sqrt(dx * dx + dy * dy + dz * dz) / scale;
+		c.level = 0;
+		while (c.level < c.maxLevel && c.error[c.level + 1] <= allowed)
+			++c.level;
+	}
+
+	// vizinhos diferem em no máximo um nível: só se refina, então termina
+	for (bool changed = true; changed;) {
+		changed = false;
+		for (int cy = 0; cy < chunksY; ++cy)
+			for (int cx = 0; cx < chunksX; ++cx) {
+				Chunk &c = chunks[cx + size_t(cy) * chunksX];
+				int limit = c.level;
+				if (cx > 0)
+					limit = std::min(limit, chunks[cx - 1 + size_t(cy) * chunksX].level + 1);
+				if (cx + 1 < chunksX)
+					limit = std::min(limit, chunks[cx + 1 + size_t(cy) * chunksX].level + 1);
+				if (cy > 0)
+					limit = std::min(limit, chunks[cx + size_t(cy - 1) * chunksX].level + 1);
+				if (cy + 1 < chunksY)
+					limit = std::min(limit, chunks[cx + size_t(cy + 1) * chunksX].level + 1);
+				if (limit < c.level) {
+					c.level = limit;
+					changed = true;
+				}
+			}
+	}
+
+	bool same = previous.size() == chunks.size();
+	for (size_t k = 0; same && k < chunks.size(); ++k)
+		same = previous[k] == chunks[k].level;
+	if (same)
+		return false;
+	previous.resize(chunks.size());
+	for (size_t k = 0; k < chunks.size(); ++k)
+		previous[k] = chunks[k].level;
+
+	indexList.clear();
+	counts.assign(MAX_LEVEL + 1, 0);
+	for (int cy = 0; cy < chunksY; ++cy)
+		for (int cx = 0; cx < chunksX; ++cx) {
+			const Chunk &c = chunks[cx + size_t(cy) * chunksX];
+			auto coarserAt = [&](int x, int y) {
+				return x >= 0 && x < chunksX && y >= 0 && y < chunksY &&
+				       chunks[x + size_t(y) * chunksX].level > c.level;
+			};
+			int coarser = coarserAt(cx - 1, cy) | coarserAt(cx + 1, cy) << 1 | coarserAt(cx, cy - 1) << 2 |
+			              coarserAt(cx, cy + 1) << 3;
+			const unsigned base = unsigned(c.i0 + size_t(c.j0) * (n + 1));
+			for (int offset : pattern(c.cw, c.ch, c.level, coarser))
+				indexList.push_back(base + offset);
+			++counts[c.level];
+		}
+	return true;
+}
@@ -0,0 +1,68 @@
+#ifndef LOD_H
+#define LOD_H
+
+#include "camera.h"
+#include "grid.h"
+#include <map>
+#include <vector>
+
+// Nível de detalhe por blocos para malhas grandes. O campo é dividido em
+// blocos de CHUNK x CHUNK células (os da última coluna e da última linha
+// podem ser menores); o nível l de um bloco usa só os nós de passo 2^l, e
+// para cada nível guarda-se o erro geométrico, o maior |u - u interpolado|
+// entre o campo e a malha reduzida, nos mesmos triângulos que o desenho usa.
+//
+// A cada quadro, select() projeta esse erro na tela pela distância entre o
+// olho e a caixa do bloco e escolhe, por bloco, o nível mais grosso com erro
+// até `pixelError` pixels. Blocos vizinhos diferem em no máximo um nível, e
+// a emenda não deixa frestas: no lado em que o vizinho é mais grosso, os
+// nós ímpares da borda saem da triangulação e cada par de segmentos vira
+// um segmento do vizinho, com um triângulo de leque até o nó de dentro.
+//
+// Os índices são os dos nós no campo (i + j*(N+1)), os mesmos do VBO de
+// MeshRenderer, e formam uma lista de triângulos (GL_TRIANGLES). O custo
+// por quadro é proporcional ao número de blocos e de triângulos
+// desenhados, não ao de nós.
+class SurfaceLod {
+public:
+	static const int CHUNK = 64; // células por lado de um bloco
+	static const int MAX_LEVEL = 6; // nível mais grosso: passo 64, uma célula por bloco
+
+	// Recalcula os erros de cada nível para o campo atual; a divisão em
+	// blocos só é refeita quando N ou M mudam.
+	void build(const PoissonGrid &g);
+	// Escolhe os níveis para a câmera numa janela de `viewportHeight` pixels
+	// de altura. Devolve true se os índices mudaram desde a última chamada.
+	bool select(const OrbitCamera &camera, int viewportHeight, float pixelError);
+
+	bool empty() const { return chunks.empty(); }
+	const std::vector<unsigned> &indices() const { return indexList; }
+	long triangles() const { return long(indexList.size() / 3); }
+	// quantos blocos ficaram em cada nível na última seleção
+	const std::vector<int> &levelCounts() const { return counts; }
+
+private:
+	struct Chunk {
+		int i0, j0, cw, ch; // primeiro nó e tamanho em células
+		int maxLevel;
+		float umin, umax;
+		float error[MAX_LEVEL + 1];
+		int level;
+	};
+	void computeErrors(Chunk &c, const float *u) const;
+	// triangulação de um bloco cw x ch no nível `level`, em deslocamentos a
+	// partir do primeiro nó; o bit k de `coarser` marca o lado -x, +x, -y, +y
+	// com vizinho um nível acima
+	const std::vector<int> &pattern(int cw, int ch, int level, int coarser);
+
+	int n = 0, m = 0;
+	int chunksX = 0, chunksY = 0;
+	float hx = 0.0f, ky = 0.0f;
+	std::vector<Chunk> chunks;
+	std::map<long, std::vector<int>> patterns;
+	std::vector<int> previous; // níveis da última seleção
+	std::vector<unsigned> indexList;
+	std::vector<int> counts;
+};
+
+#endif
@@ -1,144 +1,274 @@
-#include "IM472.h"
+#include "camera.h"
+#include "contour.h"
+#include "grid.h"
+#include "lod.h"
+#include "mesh_renderer.h"
+#include "profiler.h"
+#include "solver_thread.h"
 #include <GL/glut.h>
+#include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <cstdio>
+#include <cstdlib>
 #include <iostream>
-
-// Parâmetros da malha
-const int N = 50; // número de divisões em x [0,2]
-const int M = 25; // número de divisões em y [0,1]
-const float h = 2.0f / float(N); // número de passos em x
-const float k = 1.0f / float(M); // número de passos em y
-
-// Variáveis globais
-float *solution = nullptr;
-
-float maxValue = 1.0f;
-
-// Ponto central do gráfico (alvo). Ajuste conforme a posição real do seu gráfico.
-float targetX = 0.0f, targetY = 1.5f, targetZ = 0.0f;
-
-// Parâmetros polares da câmera em torno do alvo
-float radius = 12.0f; // distância inicial entre câmera e alvo
-float azimuth = 0.0f; // ângulo horizontal em graus (gira em torno do eixo Y do alvo)
-float elevation = 10.0f; // ângulo vertical em graus (inclinação acima do plano XZ)
-
-// Vetor “up” fixo. Normalmente (0,1,0).
-float upX = 0.0f, upY = 1.0f, upZ = 0.0f;
+#include <numeric>
+#include <string>
+
+// Malha e solver; N e M vêm da linha de comando (padrão 50 x 25)
+PoissonGrid grid;
+SolverOptions solverOptions;
+
+// O solver roda em segundo plano; enquanto ele trabalha, a interface
+// consulta o último iterado a cada pollInterval ms e redesenha quando chega
+// um novo. Com o solver parado, não há timer nenhum.
+SolverThread solver;
+SolverSnapshot snapshot;
+const int pollInterval = 16;
+bool polling = false;
+
+// Desenho sob demanda: só se pede um quadro quando algo visível muda, e no
+// máximo um a cada frameInterval ms; os pedidos que chegam antes (rajadas
+// de repetição de tecla, iterados do solver) viram um redesenho só
+const int frameInterval = 16;
+bool redrawPending = false;
+int lastFrame = -frameInterval;
+
+// limites para dobrar/reduzir a malha pelo teclado
+const int minDivisions = 2;
+const int maxDivisions = 16384;
+
+// faixa de valores do campo, para as cores
+float minValue = 0.0f, maxValue = 1.0f;
+
+// Desenho da malha: em modo retido (buffers do OpenGL, refeitos só quando o
+// campo muda) ou no modo imediato original, glBegin/glVertex a cada quadro.
+// meshDirty marca o campo novo, ainda não enviado ao VBO.
+MeshRenderer meshRenderer;
+bool meshDirty = true;
+bool retainedMode = true;
+
+// Nível de detalhe por blocos (lod.h) no modo retido: a tecla l liga e
+// desliga, [ e ] mudam o erro tolerado na tela, em pixels. lodDirty pede
+// os erros de novo (campo novo); lodViewDirty, só uma nova escolha de
+// níveis (câmera, janela ou tolerância)
+SurfaceLod surfaceLod;
+bool lodEnabled = true;
+bool lodDirty = true;
+bool lodViewDirty = true;
+float lodPixelError = 1.0f;
+int windowWidth = 800, windowHeight = 600;
+
+// Curvas de nível (contour.h) sobre a superfície: a tecla o liga e desliga,
+// , e . dividem e dobram o número de níveis. contourFieldDirty pede as faixas
+// dos blocos de novo (campo novo); contourLevelsDirty, só a extração.
+Contours contours;
+bool showContours = false;
+bool contourFieldDirty = true;
+bool contourLevelsDirty = true;
+int contourCount = 10;
+const int maxContours = 256;
+
+// Perfil dos quadros (profiler.h): a tecla p mostra os números do último
+// quadro na janela, t grava o histórico em perfil.csv. O solver entra com o
+// último iterado mostrado e o tempo desde o início do solve.
+FrameProfiler profiler;
+bool showOverlay = false;
+std::chrono::steady_clock::time_point solveStart;
+int shownIteration = 0;
+double shownResidual = 0.0;
+
+// mapa de cores; a tecla m troca e a textura é reenviada no próximo quadro
+Colormap colormap;
+bool colormapDirty = true;
+
+// Câmera orbital em torno do alvo (camera.h), a mesma do modo sem janela
+OrbitCamera camera;
 
 // parâmetros de sensibilidade
 const float angularSpeed = 5.0f; // graus por tecla para azimuth/elevation
 const float zoomSpeed = 0.5f; // quanto muda o radius por tecla
 const float panSpeed = 0.1f;
 
-float meshRotX = 0.0f; // rotação da malha em torno do eixo X local
-float meshRotY = 0.0f; // rotação da malha em torno do eixo Y local
-
 // visualização do wireframe
 bool wireframe = false;
 
+// iluminação da superfície com as normais da malha (tecla n); a luz é
+// direcional e acompanha o olho (OrbitCamera::LIGHT, a mesma do headless)
+bool lighting = true;
+const GLfloat lightDirection[4] = {OrbitCamera::LIGHT[0], OrbitCamera::LIGHT[1], OrbitCamera::LIGHT[2], 0.0f};
+
 // converte os índices da malha (i,j) para coordenadas (x,y)
-void getCoordinates(int i, int j, float &x, float &y) {
-	x = (float)i * h;
-	y = (float)j * k;
+void getCoordinates(const PoissonGrid &g, int i, int j, float &x, float &y) {
+	g.getCoordinates(i, j, x, y);
 }
 
 // obtém o valor da solução no ponto (i,j)
-float getSolutionValue(int i, int j) {
-	// pontos interiores da malha
-	if (i > 0 && i < N && j > 0 && j < M) {
-		return solution[(i - 1) + (j - 1) * (N - 1)];
-	}
+float getSolutionValue(const PoissonGrid &g, int i, int j) {
+	return g.value(i, j);
+}
 
-	float x, y;
-	getCoordinates(i, j, x, y);
+void redrawTimer(int) {
+	glutPostRedisplay();
+}
 
-	// condições de contorno
-	if (i == 0)
-		return 0.0f; // u(0,y) = 0
-	if (i == N)
-		return 2.0f * expf(y); // u(2,y) = 2e^y
-	if (j == 0)
-		return x; // u(x,0) = x
-	if (j == M)
-		return expf(x); // u(x,1) = e^x
+// pede um quadro; se o último foi há menos de frameInterval ms, adia para
+// completar o intervalo, e pedidos até lá não agendam outro
+void requestRedraw() {
+	if (redrawPending)
+		return;
+	redrawPending = true;
+	int wait = lastFrame + frameInterval - glutGet(GLUT_ELAPSED_TIME);
+	if (wait > 0)
+		glutTimerFunc(wait, redrawTimer, 0);
+	else
+		glutPostRedisplay();
+}
+
+// a câmera mudou: só a escolha de níveis do detalhe precisa ser refeita
+void viewChanged() {
+	lodViewDirty = true;
+	requestRedraw();
+}
 
-	return 0.0f;
+// atualiza a faixa das cores com o mínimo e o máximo do campo
+void updateValueRange(const PoissonGrid &g) {
+	minValue = g.fieldStats().min();
+	maxValue = g.fieldStats().max();
+	meshDirty = true;
+	contourFieldDirty = true;
 }
 
-// Calcula o valor máximo da solução para normalização
-float getMaxSolutionValue() {
-	float maxVal = 0.0f;
-	// Verificar pontos interiores
-	for (int idx = 0; idx < (N - 1) * (M - 1); idx++) {
-		if (fabs(solution[idx]) > maxVal)
-			maxVal = fabs(solution[idx]);
+// histograma do campo no terminal, uma linha por faixa de valores
+void printHistogram(const PoissonGrid &g) {
+	const FieldStats &fs = g.fieldStats();
+	const std::vector<unsigned> &h = fs.histogram();
+	const int groups = 16, per = FieldStats::BINS / groups;
+	unsigned top = 1;
+	for (int k = 0; k < groups; ++k)
+		top = std::max(top, unsigned(std::accumulate(h.begin() + k * per, h.begin() + (k + 1) * per, 0u)));
+	float width = (fs.histogramMax() - fs.histogramMin()) / groups;
+	std::cout << "u em [" << fs.min() << ", " << fs.max() << "], média " << fs.mean() << "\n";
+	for (int k = 0; k < groups; ++k) {
+		unsigned c = std::accumulate(h.begin() + k * per, h.begin() + (k + 1) * per, 0u);
+		char label[64];
+		snprintf(label, sizeof label, "%9.3f a %9.3f %9u ", fs.histogramMin() + k * width,
+		         fs.histogramMin() + (k + 1) * width, c);
+		std::cout << label << std::string(size_t(50.0 * c / top + 0.5), '#') << "\n";
 	}
+}
 
-	// Verificar condições de contorno
-	float x, y;
-	for (int i = 0; i <= N; i++) {
-		for (int j = 0; j <= M; j++) {
-			getCoordinates(i, j, x, y);
-			if (i == N) { // u(2,y) = 2e^y
-				float val = 2.0f * expf(y);
-				maxVal = std::max(maxVal, val);
-			}
-			if (j == M) { // u(x,1) = e^x
-				float val = expf(x);
-				maxVal = std::max(maxVal, val);
-			}
-		}
+void pollSolver(int);
+
+// começa a resolver na malha atual; o resultado chega por pollSolver()
+void solveGrid() {
+	SolverOptions opt = solverOptions;
+	opt.warmStart = grid.warmStartReady();
+	updateValueRange(grid);
+	solver.start(grid.N(), grid.M(), opt, grid.solution());
+	solveStart = std::chrono::steady_clock::now();
+	shownIteration = 0;
+	shownResidual = 0.0;
+	requestRedraw();
+	if (!polling) {
+		polling = true;
+		glutTimerFunc(pollInterval, pollSolver, 0);
 	}
+}
 
-	return maxVal;
+void printStats(const SolverStats &st) {
+	std::cout << "Malha " << grid.N() << " x " << grid.M() << " (" << solverName(solverOptions.method)
+	          << "): " << st.iterations << " iterações, resíduo " << st.residual << ", " << st.seconds * 1e3
+	          << " ms";
+	if (st.warmStart)
+		std::cout << " (partida a quente, resíduo inicial " << st.initialResidual << ")";
+	std::cout << "\n";
 }
 
-// Atribui uma cor conforme o valor da função
-void setColorByValue(float value, float maxValue) {
-	// Normaliza o valor entre 0 e 1
-	float normalizedValue = 0.5f * (value / maxValue + 1.0f);
-
-	// Mapa de cores HSV-like (do azul ao vermelho)
-	if (normalizedValue < 0.25f) {
-		// Azul para ciano
-		glColor3f(0.0f, 4.0f * normalizedValue, 1.0f);
-	} else if (normalizedValue < 0.5f) {
-		// Ciano para verde
-		glColor3f(0.0f, 1.0f, 1.0f - 4.0f * (normalizedValue - 0.25f));
-	} else if (normalizedValue < 0.75f) {
-		// Verde para amarelo
-		glColor3f(4.0f * (normalizedValue - 0.5f), 1.0f, 0.0f);
-	} else {
-		// Amarelo para vermelho
-		glColor3f(1.0f, 1.0f - 4.0f * (normalizedValue - 0.75f), 0.0f);
+// pega o iterado mais recente do solver e atualiza a malha e as cores
+void pollSolver(int) {
+	// lido antes de latest(): com o solver parado, o resultado final já
+	// foi publicado e é pego agora
+	const bool running = solver.busy();
+	if (solver.latest(snapshot) && snapshot.N == grid.N() && snapshot.M == grid.M()) {
+		if (snapshot.final) {
+			grid.setSolution(snapshot.solution, snapshot.stats);
+			printStats(snapshot.stats);
+			glutSetWindowTitle("Visualização da Equação de Poisson");
+		} else {
+			grid.setIterate(snapshot.solution);
+			char title[128];
+			snprintf(title, sizeof title, "Visualização da Equação de Poisson - iteração %d, resíduo %.2e",
+			         snapshot.iteration, snapshot.residual);
+			glutSetWindowTitle(title);
+		}
+		shownIteration = snapshot.iteration;
+		shownResidual = snapshot.residual;
+		updateValueRange(grid);
+		requestRedraw();
 	}
+	polling = running;
+	if (polling)
+		glutTimerFunc(pollInterval, pollSolver, 0);
 }
 
-void drawMesh() {
+// Atribui uma cor conforme o valor da função, pela tabela do mapa de cores
+void setColorByValue(float value, float minValue, float maxValue) {
+	// Normaliza o valor entre 0 e 1
+	float range = maxValue > minValue ? maxValue - minValue : 1.0f;
+	glColor3ubv(colormap.color(Colormap::index((value - minValue) / range)));
+}
+
+// Caminho de comparação sem cache: tudo é recalculado a cada quadro, mas a
+// normal de cada nó uma vez só (a coluna i+1 da faixa vira a coluna i da
+// seguinte).
+void drawMesh(const PoissonGrid &g) {
+	const int M = g.M();
+	std::vector<float> left(3 * (M + 1)), right(3 * (M + 1));
+	for (int j = 0; j <= M; ++j)
+		g.normal(0, j, left[3 * j], left[3 * j + 1], left[3 * j + 2]);
 	// Desenha faixas entre i e i+1
-	for (int i = 0; i < N; ++i) {
+	for (int i = 0; i < g.N(); ++i) {
+		for (int j = 0; j <= M; ++j)
+			g.normal(i + 1, j, right[3 * j], right[3 * j + 1], right[3 * j + 2]);
 		glBegin(GL_TRIANGLE_STRIP);
 		for (int j = 0; j <= M; ++j) {
 			// ponto (i, j)
 			float x1, y1;
-			getCoordinates(i, j, x1, y1);
-			float s1 = getSolutionValue(i, j);
+			getCoordinates(g, i, j, x1, y1);
+			float s1 = getSolutionValue(g, i, j);
 			// ponto (i+1, j)
 			float x2, y2;
-			getCoordinates(i + 1, j, x2, y2);
-			float s2 = getSolutionValue(i + 1, j);
+			getCoordinates(g, i + 1, j, x2, y2);
+			float s2 = getSolutionValue(g, i + 1, j);
 
 			// Vértice: X, altura (s), profundidade (y)
-			setColorByValue(s1, maxValue);
+			setColorByValue(s1, minValue, maxValue);
+			glNormal3fv(&left[3 * j]);
 			glVertex3f(x1, s1, y1);
 
-			setColorByValue(s2, maxValue);
+			setColorByValue(s2, minValue, maxValue);
+			glNormal3fv(&right[3 * j]);
 			glVertex3f(x2, s2, y2);
 		}
 		glEnd();
+		left.swap(right);
 	}
 }
 
+// curvas de nível em preto, na altura u = L de cada uma
+void drawContours() {
+	const std::vector<float> &p = contours.points();
+	if (p.empty())
+		return;
+	glColor3f(0.0f, 0.0f, 0.0f);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glVertexPointer(3, GL_FLOAT, 0, p.data());
+	for (const Contours::Polyline &line : contours.polylines())
+		glDrawArrays(line.closed ? GL_LINE_LOOP : GL_LINE_STRIP, line.first, line.count);
+	glDisableClientState(GL_VERTEX_ARRAY);
+}
+
 void drawAxes() {
 	glLineWidth(2.0f);
 	glBegin(GL_LINES);
@@ -162,26 +292,69 @@ void drawAxes() {
 	glLineWidth(1.0f);
 }
 
+// texto em Latin-1 das fontes do GLUT, a partir do UTF-8 do fonte
+void drawText(int x, int y, const char *text) {
+	glRasterPos2i(x, y);
+	for (const unsigned char *c = (const unsigned char *)text; *c; ++c) {
+		int code = *c;
+		if ((code & 0xe0) == 0xc0 && c[1]) {
+			code = (code & 0x1f) << 6 | (c[1] & 0x3f);
+			++c;
+		}
+		glutBitmapCharacter(GLUT_BITMAP_8_BY_13, code < 256 ? code : '?');
+	}
+}
+
+// números do último quadro medido, no canto superior esquerdo
+void drawOverlay() {
+	if (!showOverlay || profiler.size() == 0)
+		return;
+	const FrameProfiler::Frame &f = profiler.at(profiler.size() - 1);
+	char line[3][192];
+	snprintf(line[0], sizeof line[0], "quadro %.2f ms (%.1f qps): montagem %.2f, desenho %.2f, troca %.2f ms",
+	         f.total, profiler.fps(), f.stage[FrameProfiler::BUILD], f.stage[FrameProfiler::DRAW],
+	         f.stage[FrameProfiler::SWAP]);
+	snprintf(line[1], sizeof line[1], "malha %d x %d: %ld vértices, %ld triângulos (%s)", f.N, f.M, f.vertices,
+	         f.triangles, !retainedMode ? "imediato" : lodEnabled ? "retido, com detalhe" : "retido");
+	snprintf(line[2], sizeof line[2], "solver %s: iteração %d, resíduo %.2e, %.1f ms%s", solverName(solverOptions.method),
+	         f.iteration, f.residual, f.solveMs, f.solving ? " (resolvendo)" : "");
+
+	glMatrixMode(GL_PROJECTION);
+	glPushMatrix();
+	glLoadIdentity();
+	gluOrtho2D(0, windowWidth, 0, windowHeight);
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+	glLoadIdentity();
+	glPushAttrib(GL_ENABLE_BIT | GL_CURRENT_BIT);
+	glDisable(GL_DEPTH_TEST);
+	glColor3f(1.0f, 1.0f, 1.0f);
+	for (int k = 0; k < 3; ++k)
+		drawText(8, windowHeight - 18 - 16 * k, line[k]);
+	glPopAttrib();
+	glPopMatrix();
+	glMatrixMode(GL_PROJECTION);
+	glPopMatrix();
+	glMatrixMode(GL_MODELVIEW);
+}
+
 // Função para renderizar
 void display() {
+	redrawPending = false;
+	lastFrame = glutGet(GLUT_ELAPSED_TIME);
+	profiler.beginFrame();
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-	float radAz = azimuth * M_PI / 180.0f;
-	float radEl = elevation * M_PI / 180.0f;
-	// Cálculo da posição da câmera em coordenadas esféricas em torno do alvo:
-	float cosEl = cos(radEl);
-	float sinEl = sin(radEl);
-	float cosAz = cos(radAz);
-	float sinAz = sin(radAz);
-
-	float camX = targetX + radius * cosEl * sinAz;
-	float camY = targetY + radius * sinEl;
-	float camZ = targetZ + radius * cosEl * cosAz;
+	// Posição da câmera em coordenadas esféricas em torno do alvo
+	float camX, camY, camZ;
+	camera.eye(camX, camY, camZ);
 
 	// Configura view matrix com gluLookAt
 	glMatrixMode(GL_MODELVIEW);
 	glLoadIdentity();
-	gluLookAt(camX, camY, camZ, targetX, targetY, targetZ, upX, upY, upZ);
+	// direção da luz em coordenadas do olho, antes da câmera
+	glLightfv(GL_LIGHT0, GL_POSITION, lightDirection);
+	gluLookAt(camX, camY, camZ, camera.targetX, camera.targetY, camera.targetZ, 0.0f, 1.0f, 0.0f);
 
 	// Define o modo de desenho
 	if (wireframe) {
@@ -191,119 +364,364 @@ void display() {
 	}
 
 	glPushMatrix();
-	glTranslatef(-targetX, -targetY, -targetZ);
-	glRotatef(meshRotX, 1, 0, 0);
-	glRotatef(meshRotY, 0, 1, 0);
+	glTranslatef(-camera.targetX, -camera.targetY, -camera.targetZ);
+	glRotatef(camera.meshRotX, 1, 0, 0);
+	glRotatef(camera.meshRotY, 0, 1, 0);
 
 	drawAxes();
-	drawMesh();
+	profiler.mark(FrameProfiler::DRAW);
+	FrameProfiler::Frame &f = profiler.current();
+	f.N = grid.N();
+	f.M = grid.M();
+	f.triangles = 2L * grid.N() * grid.M();
+	// com as curvas, a superfície recua um pouco na profundidade para as
+	// linhas sobre ela não sumirem entre os triângulos
+	if (showContours) {
+		glEnable(GL_POLYGON_OFFSET_FILL);
+		glPolygonOffset(1.0f, 1.0f);
+	}
+	if (lighting)
+		glEnable(GL_LIGHTING);
+	if (retainedMode) {
+		if (colormapDirty) {
+			meshRenderer.setColormap(colormap);
+			colormapDirty = false;
+		}
+		if (meshDirty) {
+			meshRenderer.update(grid);
+			meshDirty = false;
+			lodDirty = true;
+		}
+		if (lodEnabled) {
+			if (lodDirty) {
+				surfaceLod.build(grid);
+				lodDirty = false;
+				lodViewDirty = true;
+			}
+			if (lodViewDirty && surfaceLod.select(camera, windowHeight, lodPixelError))
+				meshRenderer.setLodTriangles(surfaceLod.indices());
+			lodViewDirty = false;
+			f.triangles = surfaceLod.triangles();
+		}
+		profiler.mark(FrameProfiler::BUILD);
+		meshRenderer.draw(minValue, maxValue, lodEnabled);
+		f.vertices = meshRenderer.drawnVertices(lodEnabled);
+	} else {
+		drawMesh(grid);
+		f.vertices = 2L * grid.N() * (grid.M() + 1);
+	}
+	glDisable(GL_LIGHTING);
+	if (showContours) {
+		glDisable(GL_POLYGON_OFFSET_FILL);
+		profiler.mark(FrameProfiler::DRAW);
+		if (contourFieldDirty) {
+			contours.setField(grid);
+			contourFieldDirty = false;
+			contourLevelsDirty = true;
+		}
+		if (contourLevelsDirty) {
+			contours.extract(Contours::evenLevels(minValue, maxValue, contourCount));
+			contourLevelsDirty = false;
+		}
+		profiler.mark(FrameProfiler::BUILD);
+		drawContours();
+	}
 	glPopMatrix();
+	profiler.mark(FrameProfiler::DRAW);
+
+	f.iteration = shownIteration;
+	f.residual = shownResidual;
+	// até o resultado final chegar à malha, conta como resolvendo
+	f.solving = polling;
+	if (f.solving)
+		f.solveMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - solveStart).count();
+	else if (grid.solved())
+		f.solveMs = grid.stats().seconds * 1e3;
+	drawOverlay();
+	profiler.mark(FrameProfiler::OVERLAY);
 
 	glutSwapBuffers();
+	profiler.mark(FrameProfiler::SWAP);
+	profiler.endFrame();
+}
+
+// Mede o tempo por quadro nos caminhos de desenho (imediato, retido e
+// retido com nível de detalhe), com glFinish para contar o trabalho do
+// driver (no llvmpipe, a rasterização também)
+void benchmarkFrames() {
+	const int frames = 20;
+	const bool savedRetained = retainedMode, savedLod = lodEnabled;
+	std::cout << "Malha " << grid.N() << " x " << grid.M() << ", " << frames << " quadros:\n";
+	for (int mode = 0; mode < 3; ++mode) {
+		retainedMode = mode > 0;
+		lodEnabled = mode == 2;
+		auto t0 = std::chrono::steady_clock::now();
+		if (mode == 1) {
+			meshRenderer.update(grid);
+			meshDirty = false;
+			glFinish();
+			double build = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+			std::cout << "  montagem dos buffers: " << build * 1e3 << " ms\n";
+			t0 = std::chrono::steady_clock::now();
+		} else if (mode == 2) {
+			surfaceLod.build(grid);
+			lodDirty = false;
+			lodViewDirty = true;
+			double build = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+			std::cout << "  erros do nível de detalhe: " << build * 1e3 << " ms\n";
+			t0 = std::chrono::steady_clock::now();
+		}
+		for (int f = 0; f < frames; ++f) {
+			display();
+			glFinish();
+		}
+		double dt = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count() / frames;
+		const char *name[] = {"modo imediato:", "modo retido:  ", "com detalhe:  "};
+		std::cout << "  " << name[mode] << " " << dt * 1e3 << " ms/quadro";
+		if (mode == 2)
+			std::cout << " (" << surfaceLod.triangles() << " de " << 2L * grid.N() * grid.M() << " triângulos)";
+		std::cout << "\n";
+	}
+	retainedMode = savedRetained;
+	lodEnabled = savedLod;
 }
 
 void reshape(int width, int height) {
+	windowWidth = width;
+	windowHeight = height;
+	lodViewDirty = true;
 	glViewport(0, 0, width, height);
 	glMatrixMode(GL_PROJECTION);
 	glLoadIdentity();
-	gluPerspective(45.0f, (float)width / (float)height, 0.1f, 100.0f);
+	gluPerspective(OrbitCamera::FOVY, (float)width / (float)height, OrbitCamera::Z_NEAR, OrbitCamera::Z_FAR);
 	glMatrixMode(GL_MODELVIEW);
 }
 
-void keyboard(unsigned char key, int x, int y) {
+// As teclas só marcam o que mudou: a câmera pede uma nova escolha de
+// níveis (viewChanged), o mapa de cores a textura, e as que não mudam nada
+// na tela (c, h, e, g, t, b, ou +/- no limite) não pedem quadro.
+void keyboard(unsigned char key, int, int) {
 	switch (key) {
 	case 27: // ESC
-		delete[] solution;
 		exit(0);
 		break;
 
+	// Resolução da malha: dobra ou reduz N e M pela metade e resolve de novo
+	case '+':
+	case '=':
+		if (2 * grid.N() <= maxDivisions && 2 * grid.M() <= maxDivisions) {
+			grid.resize(2 * grid.N(), 2 * grid.M());
+			solveGrid();
+		}
+		break;
+	case '-':
+	case '_':
+		if (grid.N() / 2 >= minDivisions && grid.M() / 2 >= minDivisions) {
+			grid.resize(grid.N() / 2, grid.M() / 2);
+			solveGrid();
+		}
+		break;
+	case 'c':
+	case 'C':
+		grid.setWarmStart(!grid.warmStartEnabled());
+		std::cout << "Partida a quente " << (grid.warmStartEnabled() ? "ligada" : "desligada") << "\n";
+		break;
+	case 'm':
+	case 'M':
+		colormap = Colormap(ColormapKind((int(colormap.kind()) + 1) % 3));
+		colormapDirty = true;
+		std::cout << "Mapa de cores " << colormapName(colormap.kind()) << "\n";
+		requestRedraw();
+		break;
+	case 'v':
+	case 'V':
+		retainedMode = !retainedMode;
+		std::cout << "Desenho em modo " << (retainedMode ? "retido (VBO)" : "imediato") << "\n";
+		requestRedraw();
+		break;
+	case 'l':
+	case 'L':
+		lodEnabled = !lodEnabled;
+		std::cout << "Nível de detalhe " << (lodEnabled ? "ligado" : "desligado") << "\n";
+		viewChanged();
+		break;
+	case '[':
+	case ']':
+		lodPixelError = key == ']' ? lodPixelError * 2.0f : std::max(lodPixelError / 2.0f, 0.125f);
+		std::cout << "Erro tolerado de " << lodPixelError << " pixel(s)\n";
+		viewChanged();
+		break;
+	case 'n':
+	case 'N':
+		lighting = !lighting;
+		std::cout << "Iluminação " << (lighting ? "ligada" : "desligada") << "\n";
+		requestRedraw();
+		break;
+	case 'o':
+	case 'O':
+		showContours = !showContours;
+		std::cout << "Curvas de nível " << (showContours ? "ligadas" : "desligadas") << "\n";
+		requestRedraw();
+		break;
+	case ',':
+	case '<':
+	case '.':
+	case '>':
+		contourCount = key == '.' || key == '>' ? std::min(2 * contourCount, maxContours)
+		                                        : std::max(contourCount / 2, 1);
+		contourLevelsDirty = true;
+		std::cout << contourCount << " curvas de nível\n";
+		if (showContours)
+			requestRedraw();
+		break;
+	case 'g':
+	case 'G':
+		if (contourFieldDirty || contourLevelsDirty) {
+			contours.setField(grid);
+			contours.extract(Contours::evenLevels(minValue, maxValue, contourCount));
+			contourFieldDirty = contourLevelsDirty = false;
+		}
+		if (contours.exportPolylines("contornos.dat"))
+			std::cout << contours.polylines().size() << " polilinhas (" << contours.levels().size()
+			          << " níveis) gravadas em contornos.dat\n";
+		else
+			std::cerr << "Não foi possível gravar contornos.dat\n";
+		break;
+	case 'p':
+	case 'P':
+		showOverlay = !showOverlay;
+		requestRedraw();
+		break;
+	case 't':
+	case 'T':
+		if (profiler.writeCSV("perfil.csv"))
+			std::cout << profiler.size() << " quadros gravados em perfil.csv\n";
+		else
+			std::cerr << "Não foi possível gravar perfil.csv\n";
+		break;
+	case 'b':
+	case 'B':
+		benchmarkFrames();
+		break;
+	case 'h':
+	case 'H':
+		printHistogram(grid);
+		break;
+	case 'e':
+	case 'E':
+		if (grid.exportField("solucao.dat"))
+			std::cout << "Malha " << grid.N() << " x " << grid.M() << " gravada em solucao.dat\n";
+		else
+			std::cerr << "Não foi possível gravar solucao.dat\n";
+		break;
+
 	// Zoom (muda radius)
 	case 'u': // aproxima
 	case 'U':
-		radius -= zoomSpeed;
-		if (radius < 0.1f)
-			radius = 0.1f; // evita radius <= 0
+		if (camera.radius > 0.1f) {
+			camera.radius = std::max(camera.radius - zoomSpeed, 0.1f); // evita camera.radius <= 0
+			viewChanged();
+		}
 		break;
 	case 'j': // afasta
 	case 'J':
-		radius += zoomSpeed;
+		camera.radius += zoomSpeed;
+		viewChanged();
 		break;
 	case 'i':
 	case 'I':
-		targetY -= panSpeed;
+		camera.targetY -= panSpeed;
+		viewChanged();
 		break;
 	case 'k':
 	case 'K':
-		targetY += panSpeed;
+		camera.targetY += panSpeed;
+		viewChanged();
 		break;
 	// Rotação local da malha
 	case 'a':
 	case 'A':
-		meshRotY -= angularSpeed; // gira malha em torno de Y local
+		camera.meshRotY -= angularSpeed; // gira malha em torno de Y local
+		viewChanged();
 		break;
 	case 'd':
 	case 'D':
-		meshRotY += angularSpeed;
+		camera.meshRotY += angularSpeed;
+		viewChanged();
 		break;
 	case 'w':
 	case 'W':
-		meshRotX -= angularSpeed; // gira malha em torno de X local
+		camera.meshRotX -= angularSpeed; // gira malha em torno de X local
+		viewChanged();
 		break;
 	case 's':
 	case 'S':
-		meshRotX += angularSpeed;
+		camera.meshRotX += angularSpeed;
+		viewChanged();
 		break;
 	// Alterna wireframe
 	case 'f':
 	case 'F':
 		wireframe = !wireframe;
+		requestRedraw();
 		break;
 
 	// Recentralizar orbit
 	case 'r':
 	case 'R':
-		radius = 12.0f;
-		azimuth = 0.0f;
-		elevation = 10.0f;
-		targetX = 0.0f;
-		targetY = 1.5f;
-		targetZ = 0.f;
-		meshRotX = meshRotY = 0.0f;
+		camera.reset();
+		viewChanged();
 		break;
 	};
-	glutPostRedisplay();
 }
 
-void specialKeys(int key, int x, int y) {
+void specialKeys(int key, int, int) {
 	switch (key) {
 	case GLUT_KEY_LEFT:
-		targetX += panSpeed;
+		camera.targetX += panSpeed;
 		break;
 	case GLUT_KEY_RIGHT:
-		targetX -= panSpeed;
+		camera.targetX -= panSpeed;
 		break;
 	case GLUT_KEY_UP:
-		targetZ += panSpeed;
+		camera.targetZ += panSpeed;
 		break;
 	case GLUT_KEY_DOWN:
-		targetZ -= panSpeed;
+		camera.targetZ -= panSpeed;
 		break;
 	case GLUT_KEY_PAGE_UP:
-		targetY += panSpeed;
+		camera.targetY += panSpeed;
 		break;
 	case GLUT_KEY_PAGE_DOWN:
-		targetY -= panSpeed;
+		camera.targetY -= panSpeed;
 		break;
 	default:
-		break;
+		return;
 	}
 
-	glutPostRedisplay();
+	viewChanged();
 }
 
 int main(int argc, char **argv) {
-	// Inicializa o GLUT
+	// Inicializa o GLUT (remove de argv as opções dele)
 	glutInit(&argc, argv);
+
+	// uso: ./main [N M] [mg|pcg|sor|dst|chol] [ms entre iterados mostrados]
+	int N = 50, M = 25;
+	int arg = 1;
+	if (argc > 2 && atoi(argv[1]) > 0 && atoi(argv[2]) > 0) {
+		N = std::min(atoi(argv[1]), maxDivisions);
+		M = std::min(atoi(argv[2]), maxDivisions);
+		arg = 3;
+	}
+	if (argc > arg && !solverFromString(argv[arg], solverOptions.method)) {
+		std::cerr << "Método desconhecido: " << argv[arg] << " (use mg, pcg, sor, dst ou chol)\n";
+		return 1;
+	}
+	if (argc > arg + 1)
+		solver.setInterval(std::max(atof(argv[arg + 1]), 0.0) / 1e3);
+	grid.resize(N, M);
+
 	glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB | GLUT_DEPTH);
 	glutInitWindowSize(800, 600);
 	glutCreateWindow("Visualização da Equação de Poisson");
@@ -312,13 +730,22 @@ int main(int argc, char **argv) {
 	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 	glEnable(GL_DEPTH_TEST);
 	glShadeModel(GL_SMOOTH);
-
-	// Aloca memória para a solução
-	solution = new float[(N - 1) * (M - 1)];
-
-	// Calcula a solução numérica
-	SolPoisson(N, M, solution);
-	maxValue = getMaxSolutionValue();
+	// a cor de cada vértice (ou a da textura, no modo retido) é o material;
+	// luz ambiente fraca para o lado contra a luz não ficar preto
+	const GLfloat a = OrbitCamera::LIGHT_AMBIENT, d = OrbitCamera::LIGHT_DIFFUSE, m = OrbitCamera::GLOBAL_AMBIENT;
+	const GLfloat ambient[4] = {a, a, a, 1.0f};
+	const GLfloat diffuse[4] = {d, d, d, 1.0f};
+	const GLfloat modelAmbient[4] = {m, m, m, 1.0f};
+	glLightfv(GL_LIGHT0, GL_AMBIENT, ambient);
+	glLightfv(GL_LIGHT0, GL_DIFFUSE, diffuse);
+	glLightModelfv(GL_LIGHT_MODEL_AMBIENT, modelAmbient);
+	glEnable(GL_LIGHT0);
+	glColorMaterial(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE);
+	glEnable(GL_COLOR_MATERIAL);
+
+	// Calcula a solução numérica em segundo plano; a janela abre já com o
+	// contorno e acompanha a convergência
+	solveGrid();
 
 	std::cout << "Controles:\n";
 	std::cout << "w/a/s/d: Rotacionar visualização\n";
@@ -328,6 +755,21 @@ int main(int argc, char **argv) {
 	std::cout << "i/I: Desloca para baixo\n";
 	std::cout << "k/K: Desloca para cima\n";
 	std::cout << "r/R: Resetar visualização\n";
+	std::cout << "+/-: Dobra/reduz pela metade N e M e resolve de novo\n";
+	std::cout << "c/C: Liga/desliga a partida a quente com a solução anterior\n";
+	std::cout << "m/M: Troca o mapa de cores (rampa, viridis, turbo)\n";
+	std::cout << "v/V: Alterna o desenho entre modo retido (VBO) e imediato\n";
+	std::cout << "l/L: Liga/desliga o nível de detalhe por blocos (modo retido)\n";
+	std::cout << "[/]: Diminui/aumenta o erro tolerado do nível de detalhe, em pixels\n";
+	std::cout << "b/B: Mede o tempo por quadro nos modos de desenho\n";
+	std::cout << "n/N: Liga/desliga a iluminação da superfície\n";
+	std::cout << "o/O: Liga/desliga as curvas de nível\n";
+	std::cout << ",/.: Divide/dobra o número de curvas de nível\n";
+	std::cout << "g/G: Grava as curvas de nível em contornos.dat (x y u, polilinhas separadas por linha em branco)\n";
+	std::cout << "p/P: Mostra/esconde o perfil do último quadro (tempos, vértices, solver)\n";
+	std::cout << "t/T: Grava o histórico dos quadros em perfil.csv\n";
+	std::cout << "h/H: Mostra o histograma dos valores\n";
+	std::cout << "e/E: Grava a malha em solucao.dat (x y u, para o splot do gnuplot)\n";
 	std::cout << "ESC: Sair\n";
 
 	// Registra callbacks
@@ -0,0 +1,232 @@
+#include "mesh_renderer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+MeshRenderer::~MeshRenderer() {
+	if (vbo)
+		glDeleteBuffers(1, &vbo);
+	if (normalVbo)
+		glDeleteBuffers(1, &normalVbo);
+	if (ibo)
+		glDeleteBuffers(1, &ibo);
+	if (lodIbo)
+		glDeleteBuffers(1, &lodIbo);
+	if (texture)
+		glDeleteTextures(1, &texture);
+}
+
+void MeshRenderer::update(const PoissonGrid &g) {
+	const int N = g.N(), M = g.M();
+	if (!vbo) {
+		glGenBuffers(1, &vbo);
+		glGenBuffers(1, &normalVbo);
+		glGenBuffers(1, &ibo);
+	}
+
+	if (N != n || M != m) {
+		n = N;
+		m = M;
+		// faixa da coluna i: (i,0) (i+1,0) (i,1) (i+1,1) ... ; entre faixas,
+		// repete o último índice e o primeiro da próxima
+		std::vector<GLuint> indices;
+		indices.reserve(size_t(N) * (2 * (M + 1) + 2));
+		const GLuint s = N + 1;
+		for (int i = 0; i < N; ++i) {
+			if (i > 0)
+				indices.push_back(GLuint(i));
+			for (int j = 0; j <= M; ++j) {
+				indices.push_back(i + j * s);
+				indices.push_back(i + 1 + j * s);
+			}
+			if (i + 1 < N)
+				indices.push_back(indices.back());
+		}
+		indexCount = GLsizei(indices.size());
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+		vertices.clear();
+	}
+
+	const size_t S = N + 1;
+	const size_t count = S * (M + 1);
+	// malha nova: todas as linhas mudam, inclusive x e z
+	const bool full = vertices.size() != count;
+	vertices.resize(count);
+	normals.resize(count);
+	rowChanged.assign(M + 1, full);
+	const float *u = g.field().data();
+#pragma omp parallel for schedule(static)
+	for (int j = 0; j <= M; ++j) {
+		Vertex *row = &vertices[j * S];
+		const float *uj = u + j * S;
+		if (full) {
+			for (int i = 0; i <= N; ++i) {
+				g.getCoordinates(i, j, row[i].x, row[i].z);
+				row[i].y = uj[i];
+			}
+			continue;
+		}
+		bool changed = false;
+		for (int i = 0; i <= N; ++i) {
+			changed |= row[i].y != uj[i];
+			row[i].y = uj[i];
+		}
+		rowChanged[j] = changed;
+	}
+
+	int changedFirst = 0, changedLast = M;
+	while (changedFirst <= M && !rowChanged[changedFirst])
+		++changedFirst;
+	while (changedLast >= changedFirst && !rowChanged[changedLast])
+		--changedLast;
+
+	// a normal da linha j usa as alturas das linhas j-1, j e j+1
+	auto stale = [&](int j) {
+		return rowChanged[j] || (j > 0 && rowChanged[j - 1]) || (j < M && rowChanged[j + 1]);
+	};
+	int first = 0, last = M;
+	while (first <= M && !stale(first))
+		++first;
+	while (last >= first && !stale(last))
+		--last;
+	const float invTwoH = 0.5f / g.h(), invTwoK = 0.5f / g.k();
+	int rows = 0;
+#pragma omp parallel for schedule(static) reduction(+ : rows)
+	for (int j = first; j <= last; ++j)
+		if (stale(j)) {
+			computeNormals(u, j, invTwoH, invTwoK);
+			++rows;
+		}
+	lastUpdatedRows = rows;
+
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	if (full)
+		glBufferData(GL_ARRAY_BUFFER, count * sizeof(Vertex), vertices.data(), GL_DYNAMIC_DRAW);
+	else if (changedFirst <= changedLast)
+		glBufferSubData(GL_ARRAY_BUFFER, changedFirst * S * sizeof(Vertex),
+		                (changedLast - changedFirst + 1) * S * sizeof(Vertex), &vertices[changedFirst * S]);
+	glBindBuffer(GL_ARRAY_BUFFER, normalVbo);
+	if (full)
+		glBufferData(GL_ARRAY_BUFFER, count * sizeof(uint32_t), normals.data(), GL_DYNAMIC_DRAW);
+	else if (first <= last)
+		glBufferSubData(GL_ARRAY_BUFFER, first * S * sizeof(uint32_t), (last - first + 1) * S * sizeof(uint32_t),
+		                &normals[first * S]);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+namespace {
+
+// 1/sqrt(x) por aproximação inicial nos bits e um passo de Newton: erro
+// relativo abaixo de 0,2%, menos que o passo dos bytes da normal, e sem o
+// desvio do errno de std::sqrt, que impede o laço de vetorizar
+inline float inverseSqrt(float x) {
+	uint32_t bits;
+	std::memcpy(&bits, &x, sizeof bits);
+	bits = 0x5f375a86 - (bits >> 1);
+	float y;
+	std::memcpy(&y, &bits, sizeof y);
+	return y * (1.5f - 0.5f * x * y * y);
+}
+
+// normal (-ux, 1, -uy) normalizada, em bytes com sinal (escala 127), num
+// inteiro só: x no byte menos significativo, depois y e z. Uma escrita de 4
+// bytes por nó, no lugar de três de um byte, que não vetorizam bem.
+inline uint32_t packNormal(float ux, float uy) {
+	const float s = 127.0f * inverseSqrt(ux * ux + 1.0f + uy * uy);
+	const float x = -ux * s, z = -uy * s;
+	const int32_t nx = int32_t(x + (x < 0.0f ? -0.5f : 0.5f));
+	const int32_t ny = int32_t(s + 0.5f);
+	const int32_t nz = int32_t(z + (z < 0.0f ? -0.5f : 0.5f));
+	return uint32_t(nx & 0xff) | uint32_t(ny & 0xff) << 8 | uint32_t(nz & 0xff) << 16;
+}
+
+} // namespace
+
+void MeshRenderer::computeNormals(const float *u, int j, float invTwoH, float invTwoK) {
+	// alturas direto do campo (contíguas, iguais às de vertices), para o
+	// laço de dentro vetorizar
+	const size_t S = n + 1;
+	const float *row = u + j * S;
+	// diferença central em y; de um lado só nas linhas do contorno
+	const float *below = j > 0 ? row - S : row;
+	const float *above = j < m ? row + S : row;
+	const float dy = j > 0 && j < m ? invTwoK : 2.0f * invTwoK;
+	uint32_t *out = &normals[j * S];
+	out[0] = packNormal((row[1] - row[0]) * 2.0f * invTwoH, (above[0] - below[0]) * dy);
+#pragma omp simd
+	for (int i = 1; i < n; ++i)
+		out[i] = packNormal((row[i + 1] - row[i - 1]) * invTwoH, (above[i] - below[i]) * dy);
+	out[n] = packNormal((row[n] - row[n - 1]) * 2.0f * invTwoH, (above[n] - below[n]) * dy);
+}
+
+void MeshRenderer::setLodTriangles(const std::vector<unsigned> &indices) {
+	if (!lodIbo)
+		glGenBuffers(1, &lodIbo);
+	lodCount = GLsizei(indices.size());
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, lodIbo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+void MeshRenderer::setColormap(const Colormap &colormap) {
+	if (!texture)
+		glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_1D, texture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage1D(GL_TEXTURE_1D, 0, GL_RGB8, Colormap::SIZE, 0, GL_RGB, GL_UNSIGNED_BYTE, colormap.data());
+	glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_1D, 0);
+}
+
+void MeshRenderer::draw(float minValue, float maxValue, bool lod) const {
+	if (empty() || !texture || (lod && !lodIbo))
+		return;
+	// s = a u + b leva minValue e maxValue aos centros do primeiro e do
+	// último texel
+	const float range = maxValue > minValue ? maxValue - minValue : 1.0f;
+	const float a = float(Colormap::SIZE - 1) / Colormap::SIZE / range;
+	const float b = 0.5f / Colormap::SIZE - minValue * a;
+	glMatrixMode(GL_TEXTURE);
+	glLoadIdentity();
+	glTranslatef(b, 0.0f, 0.0f);
+	glScalef(a, 1.0f, 1.0f);
+	glMatrixMode(GL_MODELVIEW);
+	glEnable(GL_TEXTURE_1D);
+	glBindTexture(GL_TEXTURE_1D, texture);
+	// a textura multiplica a cor do vértice: branca sem iluminação, ou a
+	// luz calculada com a normal quando GL_LIGHTING está ligado
+	glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+	glColor3f(1.0f, 1.0f, 1.0f);
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, lod ? lodIbo : ibo);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	glEnableClientState(GL_NORMAL_ARRAY);
+	glBindBuffer(GL_ARRAY_BUFFER, normalVbo);
+	glNormalPointer(GL_BYTE, sizeof(uint32_t), nullptr);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glVertexPointer(3, GL_FLOAT, sizeof(Vertex), (const void *)offsetof(Vertex, x));
+	// a coordenada de textura é o y (a altura u) do próprio vértice
+	glTexCoordPointer(1, GL_FLOAT, sizeof(Vertex), (const void *)offsetof(Vertex, y));
+	if (lod)
+		glDrawElements(GL_TRIANGLES, lodCount, GL_UNSIGNED_INT, nullptr);
+	else
+		glDrawElements(GL_TRIANGLE_STRIP, indexCount, GL_UNSIGNED_INT, nullptr);
+	glDisableClientState(GL_NORMAL_ARRAY);
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glBindTexture(GL_TEXTURE_1D, 0);
+	glDisable(GL_TEXTURE_1D);
+	glMatrixMode(GL_TEXTURE);
+	glLoadIdentity();
+	glMatrixMode(GL_MODELVIEW);
+}
@@ -0,0 +1,75 @@
+#ifndef MESH_RENDERER_H
+#define MESH_RENDERER_H
+
+#define GL_GLEXT_PROTOTYPES
+#include "colormap.h"
+#include "grid.h"
+#include <GL/gl.h>
+#include <cstdint>
+#include <vector>
+
+// Malha da solução em buffers do OpenGL (modo retido). Cada vértice é a
+// posição (x, u, y) em float, 12 bytes por nó, na mesma ordem do campo de
+// PoissonGrid. Os índices formam uma única faixa de triângulos: as faixas
+// entre as colunas i e i+1 são emendadas por triângulos degenerados (o
+// último índice de uma e o primeiro da seguinte repetidos), o que funciona
+// em qualquer OpenGL 1.5, inclusive no llvmpipe, sem precisar de primitive
+// restart. Um quadro é um glDrawElements só.
+//
+// A cor vem do mapa de cores numa textura 1D. A coordenada de textura é a
+// própria altura u do vértice, e a matriz de textura leva [min, max] para a
+// tabela: trocar o mapa ou a faixa não mexe nos vértices.
+//
+// As normais ficam num segundo VBO, em três bytes com sinal (mais um de
+// enchimento) por nó: a passada que as calcula escreve 4 bytes por nó, não
+// o vértice inteiro. Saem de diferenças centrais no campo (de um lado só no
+// contorno), as mesmas de PoissonGrid::normal, em paralelo por linha j.
+// update() compara as alturas novas com as guardadas e só refaz as normais
+// das linhas que mudaram e das vizinhas, que usam essas alturas; só essas
+// faixas de linhas são reenviadas.
+//
+// Com nível de detalhe (lod.h), os mesmos vértices são desenhados com uma
+// segunda lista de índices, de triângulos, escolhida por bloco a cada quadro.
+class MeshRenderer {
+public:
+	MeshRenderer() = default;
+	~MeshRenderer();
+	MeshRenderer(const MeshRenderer &) = delete;
+	MeshRenderer &operator=(const MeshRenderer &) = delete;
+
+	// Reenvia os vértices que mudaram a partir do campo da malha; os índices
+	// só são refeitos quando N ou M mudam. Precisa de um contexto do OpenGL
+	// corrente.
+	void update(const PoissonGrid &g);
+	// envia a tabela do mapa de cores como textura 1D
+	void setColormap(const Colormap &colormap);
+	// índices de triângulos de um SurfaceLod, nos mesmos vértices
+	void setLodTriangles(const std::vector<unsigned> &indices);
+	// desenha com as cores em [minValue, maxValue]; com `lod`, usa os
+	// triângulos de setLodTriangles no lugar da malha inteira
+	void draw(float minValue, float maxValue, bool lod = false) const;
+	bool empty() const { return indexCount == 0; }
+	// vértices enviados por quadro (índices do desenho da malha inteira ou
+	// dos triângulos do nível de detalhe)
+	long drawnVertices(bool lod) const { return lod ? lodCount : indexCount; }
+	// linhas j com normais refeitas no último update()
+	int updatedRows() const { return lastUpdatedRows; }
+
+private:
+	struct Vertex {
+		float x, y, z;
+	};
+	// normais da linha j a partir do campo u
+	void computeNormals(const float *u, int j, float invTwoH, float invTwoK);
+
+	GLuint vbo = 0, normalVbo = 0, ibo = 0, lodIbo = 0, texture = 0;
+	int n = 0, m = 0;
+	GLsizei indexCount = 0, lodCount = 0;
+	int lastUpdatedRows = 0;
+	std::vector<Vertex> vertices; // cópia do VBO, comparada a cada atualização
+	std::vector<uint32_t> normals; // bytes x, y, z com sinal, do menos significativo
+
+	std::vector<char> rowChanged;
+};
+
+#endif
@@ -0,0 +1,351 @@
+#include "multigrid.h"
+#include "stencil.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+// Um nível da hierarquia. Os vetores guardam a malha completa (n+1)x(m+1),
+// contorno incluído, para o estêncil não precisar de casos especiais; nos
+// níveis grossos a incógnita é a correção, com contorno zero.
+template <typename T> struct Level {
+	int n, m;
+	T cx, cy; // 1/h² e 1/k²
+	std::vector<T> u, f, r;
+
+	Level(int n_, int m_)
+	    : n(n_), m(m_), cx(T(n_ * n_ / (X_MAX * X_MAX))), cy(T(m_ * m_ / (Y_MAX * Y_MAX))),
+	      u(size_t(n_ + 1) * (m_ + 1)), f(u.size()), r(u.size()) {}
+
+	size_t at(int i, int j) const { return i + size_t(j) * (n + 1); }
+};
+
+// varreduras vermelho-preto; omega = 1 é Gauss–Seidel
+template <typename T> void relax(Level<T> &L, int sweeps, T omega) {
+	const int s = L.n + 1;
+	const T diag = T(1) / (2 * L.cx + 2 * L.cy);
+	for (int it = 0; it < sweeps; ++it)
+		for (int color = 0; color < 2; ++color)
+			for (int j = 1; j < L.m; ++j) {
+				T *u = &L.u[L.at(0, j)];
+				const T *f = &L.f[L.at(0, j)];
+				for (int i = 1 + (j + color + 1) % 2; i < L.n; i += 2) {
+					T gs = (L.cx * (u[i - 1] + u[i + 1]) + L.cy * (u[i - s] + u[i + s]) - f[i]) * diag;
+					u[i] += omega * (gs - u[i]);
+				}
+			}
+}
+
+// r = f - Au no interior; devolve ||r||²
+template <typename T> double residual(Level<T> &L) {
+	if constexpr (std::is_same<T, double>::value) {
+		StencilGrid g{L.n, L.m, L.n + 1, L.cx, L.cy};
+		return stencilResidual(g, L.u.data(), L.f.data(), L.r.data());
+	}
+	const int s = L.n + 1;
+	double sum = 0.0;
+	for (int j = 1; j < L.m; ++j) {
+		const T *u = &L.u[L.at(0, j)];
+		const T *f = &L.f[L.at(0, j)];
+		T *r = &L.r[L.at(0, j)];
+		for (int i = 1; i < L.n; ++i) {
+			T au = L.cx * (u[i - 1] - 2 * u[i] + u[i + 1]) + L.cy * (u[i - s] - 2 * u[i] + u[i + s]);
+			r[i] = f[i] - au;
+			sum += double(r[i]) * r[i];
+		}
+	}
+	return sum;
+}
+
+// Malhas que não se dividem ao meio: o ponto fino i fica na posição
+// i·nc/n da malha grossa, entre os pontos I e I+1, e o prolongamento é a
+// interpolação linear entre eles. A restrição usa os mesmos pesos
+// transpostos, normalizados para somar 1; com n = 2nc os dois viram a
+// ponderação completa e a interpolação bilinear de baixo.
+struct Weights1D {
+	std::vector<int> index; // I de cada ponto fino
+	std::vector<double> w; // peso do ponto I+1
+	Weights1D(int n, int nc) : index(n + 1), w(n + 1) {
+		for (int i = 0; i <= n; ++i) {
+			index[i] = int(int64_t(i) * nc / n);
+			w[i] = double(int64_t(i) * nc - int64_t(index[i]) * n) / n;
+		}
+	}
+	// peso do ponto fino i no grosso I (zero fora de I-1 < i·nc/n < I+1)
+	double weight(int i, int I) const {
+		return index[i] == I ? 1.0 - w[i] : index[i] + 1 == I ? w[i] : 0.0;
+	}
+};
+
+template <typename T> void restrictGeneral(const Level<T> &F, Level<T> &C) {
+	const Weights1D wx(F.n, C.n), wy(F.m, C.m);
+	// pontos finos que caem em (I-1, I+1): um intervalo contíguo
+	auto range = [](int n, int nc, int I, int &lo, int &hi) {
+		lo = int(int64_t(I - 1) * n / nc) + 1;
+		hi = std::min(int((int64_t(I + 1) * n - 1) / nc), n - 1);
+	};
+	for (int J = 1; J < C.m; ++J) {
+		int j0, j1;
+		range(F.m, C.m, J, j0, j1);
+		for (int I = 1; I < C.n; ++I) {
+			int i0, i1;
+			range(F.n, C.n, I, i0, i1);
+			double sum = 0.0, sx = 0.0, sy = 0.0;
+			for (int i = i0; i <= i1; ++i)
+				sx += wx.weight(i, I);
+			for (int j = j0; j <= j1; ++j) {
+				const double ay = wy.weight(j, J);
+				sy += ay;
+				for (int i = i0; i <= i1; ++i)
+					sum += ay * wx.weight(i, I) * double(F.r[F.at(i, j)]);
+			}
+			C.f[C.at(I, J)] = T(sum / (sx * sy));
+		}
+	}
+}
+
+template <typename T> void prolongateGeneral(const Level<T> &C, Level<T> &F) {
+	const Weights1D wx(F.n, C.n), wy(F.m, C.m);
+	for (int j = 1; j < F.m; ++j) {
+		const T *c0 = &C.u[C.at(0, wy.index[j])];
+		const T *c1 = c0 + (C.n + 1);
+		const T ay = T(wy.w[j]);
+		T *u = &F.u[F.at(0, j)];
+		for (int i = 1; i < F.n; ++i) {
+			const int I = wx.index[i];
+			const T ax = T(wx.w[i]);
+			const T a = c0[I] + ax * (c0[I + 1] - c0[I]);
+			const T b = c1[I] + ax * (c1[I + 1] - c1[I]);
+			u[i] += a + ay * (b - a);
+		}
+	}
+}
+
+// f grosso = ponderação completa do resíduo fino
+template <typename T> void restrictResidual(const Level<T> &F, Level<T> &C) {
+	if (F.n != 2 * C.n || F.m != 2 * C.m) {
+		restrictGeneral(F, C);
+		std::fill(C.u.begin(), C.u.end(), T(0));
+		return;
+	}
+	const int s = F.n + 1;
+	for (int J = 1; J < C.m; ++J)
+		for (int I = 1; I < C.n; ++I) {
+			const T *r = &F.r[F.at(2 * I, 2 * J)];
+			C.f[C.at(I, J)] = (4 * r[0] + 2 * (r[-1] + r[1] + r[-s] + r[s]) + r[-s - 1] + r[-s + 1] + r[s - 1] +
+			                   r[s + 1]) /
+			                  16;
+		}
+	std::fill(C.u.begin(), C.u.end(), T(0));
+}
+
+// u fino += interpolação bilinear da correção grossa
+template <typename T> void prolongate(const Level<T> &C, Level<T> &F) {
+	if (F.n != 2 * C.n || F.m != 2 * C.m) {
+		prolongateGeneral(C, F);
+		return;
+	}
+	for (int j = 1; j < F.m; ++j) {
+		const T *c0 = &C.u[C.at(0, j / 2)];
+		const T *c1 = j % 2 ? &C.u[C.at(0, j / 2 + 1)] : c0;
+		T *u = &F.u[F.at(0, j)];
+		for (int i = 1; i < F.n; ++i) {
+			int I = i / 2;
+			if (i % 2)
+				u[i] += (c0[I] + c0[I + 1] + c1[I] + c1[I + 1]) / 4;
+			else
+				u[i] += (c0[I] + c1[I]) / 2;
+		}
+	}
+}
+
+// Nível mais grosso: SOR até reduzir o resíduo 1000 vezes. É uma malha
+// minúscula (um dos lados com menos de 4 intervalos).
+template <typename T> void coarseSolve(Level<T> &L) {
+	const T omega = T(sorOmega(L.n, L.m));
+	double r0 = residual(L);
+	const int maxSweeps = 20 * (L.n + L.m);
+	for (int it = 0; it < maxSweeps; it += 4) {
+		relax(L, 4, omega);
+		if (residual(L) <= 1e-6 * r0)
+			break;
+	}
+}
+
+template <typename T> void cycle(std::vector<Level<T>> &levels, size_t l, const SolverOptions &opt) {
+	Level<T> &L = levels[l];
+	if (l + 1 == levels.size()) {
+		coarseSolve(L);
+		return;
+	}
+	Level<T> &C = levels[l + 1];
+	relax(L, opt.preSmooth, T(1));
+	residual(L);
+	restrictResidual(L, C);
+	// no penúltimo nível uma visita já resolve o nível grosso
+	int visits = l + 2 == levels.size() ? 1 : std::max(1, opt.cycle);
+	for (int g = 0; g < visits; ++g)
+		cycle(levels, l + 1, opt);
+	prolongate(C, L);
+	relax(L, opt.postSmooth, T(1));
+}
+
+// copia o interior do nível fino para o layout da solução
+template <typename T> void storeInterior(const Level<T> &F, float *solution) {
+	for (int j = 1; j < F.m; ++j)
+		for (int i = 1; i < F.n; ++i)
+			solution[(i - 1) + (j - 1) * (F.n - 1)] = float(F.u[F.at(i, j)]);
+}
+
+// malhas da hierarquia: N x M e as metades (arredondadas para cima) até
+// um dos lados ficar com menos de 4 intervalos
+template <typename T> std::vector<Level<T>> hierarchy(int N, int M) {
+	std::vector<Level<T>> levels;
+	levels.emplace_back(N, M);
+	for (int n = N, m = M; n >= 4 && m >= 4;) {
+		n = (n + 1) / 2;
+		m = (m + 1) / 2;
+		levels.emplace_back(n, m);
+	}
+	return levels;
+}
+
+// Prepara o nível fino (contorno de Dirichlet em u e termo fonte em f) e o
+// chute inicial. Devolve r0 = ||f - Au0|| com u0 = 0 no interior.
+template <typename T> double setupFine(Level<T> &F, const float *solution, const SolverOptions &opt,
+                                       SolverStats &st) {
+	const int N = F.n, M = F.m;
+	for (int j = 0; j <= M; ++j)
+		for (int i = 0; i <= N; ++i) {
+			bool border = i == 0 || i == N || j == 0 || j == M;
+			F.u[F.at(i, j)] = border ? T(boundaryValue(i, j, N, M)) : T(0);
+			F.f[F.at(i, j)] = T(poissonSource(i * (X_MAX / N), j * (Y_MAX / M)));
+		}
+	double r0 = std::sqrt(residual(F));
+	st.residual = r0 > 0.0 ? 1.0 : 0.0;
+	if (opt.warmStart && r0 > 0.0) {
+		for (int j = 1; j < M; ++j)
+			for (int i = 1; i < N; ++i)
+				F.u[F.at(i, j)] = T(solution[(i - 1) + (j - 1) * (N - 1)]);
+		st.warmStart = true;
+		st.residual = st.initialResidual = std::sqrt(residual(F)) / r0;
+	}
+	return r0;
+}
+
+// repassa o iterado ao monitor; devolve true se o solve deve parar
+template <typename T> bool notify(const Level<T> &F, const SolverOptions &opt, SolverStats &st) {
+	if (!opt.monitor)
+		return false;
+	if (float *snap = opt.monitor->snapshotBuffer(st.iterations, st.residual)) {
+		storeInterior(F, snap);
+		opt.monitor->publish();
+	}
+	if (!opt.monitor->cancelled())
+		return false;
+	st.cancelled = st.residual > opt.tolerance;
+	return true;
+}
+
+template <typename T> SolverStats solve(int N, int M, float *solution, const SolverOptions &opt) {
+	auto t0 = std::chrono::steady_clock::now();
+
+	std::vector<Level<T>> levels = hierarchy<T>(N, M);
+	Level<T> &F = levels[0];
+	SolverStats st;
+	double r0 = setupFine(F, solution, opt, st);
+	const int maxIterations = opt.maxIterations > 0 ? opt.maxIterations : 100;
+	while (st.residual > opt.tolerance && st.iterations < maxIterations) {
+		cycle(levels, 0, opt);
+		++st.iterations;
+		st.residual = std::sqrt(residual(F)) / r0;
+		if (notify(F, opt, st))
+			break;
+	}
+
+	storeInterior(F, solution);
+
+	st.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+	return st;
+}
+
+// Soma a correção E.u (se `correct`) a F.u e prepara o próximo passo:
+// E.f = f - Au, calculado em double e arredondado uma vez, e E.u = 0.
+// Devolve ||f - Au||². As duas coisas saem numa passada: a linha j+1 é
+// corrigida antes do resíduo da linha j, que já tem os três vizinhos prontos.
+double correct(Level<double> &F, Level<float> &E, bool correct) {
+	const int s = F.n + 1;
+	auto addRow = [&](int j) {
+		double *u = &F.u[F.at(0, j)];
+		float *e = &E.u[E.at(0, j)];
+		for (int i = 1; i < F.n; ++i) {
+			u[i] += e[i];
+			e[i] = 0.0f;
+		}
+	};
+	if (correct)
+		addRow(1);
+	double sum = 0.0;
+	for (int j = 1; j < F.m; ++j) {
+		if (correct && j + 1 < F.m)
+			addRow(j + 1);
+		const double *u = &F.u[F.at(0, j)];
+		const double *f = &F.f[F.at(0, j)];
+		float *e = &E.f[E.at(0, j)];
+#pragma omp simd reduction(+ : sum)
+		for (int i = 1; i < F.n; ++i) {
+			double r = f[i] - F.cx * (u[i - 1] - 2 * u[i] + u[i + 1]) - F.cy * (u[i - s] - 2 * u[i] + u[i + s]);
+			e[i] = float(r);
+			sum += r * r;
+		}
+	}
+	return sum;
+}
+
+// Refinamento iterativo: a solução e o resíduo ficam em double, e cada passo
+// resolve aproximadamente A e = r com um ciclo inteiro em float (contorno
+// zero) e soma e à solução. O erro de arredondamento do float entra só na
+// correção, que encolhe junto com o resíduo, então a precisão final é a do
+// double; o ciclo, que é quase todo o custo, lê e escreve metade dos bytes.
+SolverStats solveMixed(int N, int M, float *solution, const SolverOptions &opt) {
+	auto t0 = std::chrono::steady_clock::now();
+
+	Level<double> F(N, M);
+	std::vector<Level<float>> levels = hierarchy<float>(N, M);
+	Level<float> &E = levels[0];
+	SolverStats st;
+	double r0 = setupFine(F, solution, opt, st);
+	if (r0 > 0.0)
+		correct(F, E, false);
+	const int maxIterations = opt.maxIterations > 0 ? opt.maxIterations : 100;
+	while (st.residual > opt.tolerance && st.iterations < maxIterations) {
+		cycle(levels, 0, opt);
+		++st.iterations;
+		st.residual = std::sqrt(correct(F, E, true)) / r0;
+		if (notify(F, opt, st))
+			break;
+	}
+
+	storeInterior(F, solution);
+
+	st.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+	return st;
+}
+
+} // namespace
+
+SolverStats solveMultigrid(int N, int M, float *solution, const SolverOptions &opt) {
+	switch (opt.precision) {
+	case Precision::Float:
+		return solve<float>(N, M, solution, opt);
+	case Precision::Mixed:
+		return solveMixed(N, M, solution, opt);
+	case Precision::Double:
+	default:
+		return solve<double>(N, M, solution, opt);
+	}
+}
@@ -0,0 +1,20 @@
+#ifndef MULTIGRID_H
+#define MULTIGRID_H
+
+#include "poisson.h"
+
+// Multigrid geométrico (ciclo V ou W) para o problema de poisson.h.
+// Suavizador Gauss–Seidel vermelho-preto, restrição por ponderação completa e
+// prolongamento bilinear. A malha é engrossada pela metade (para cima, quando
+// N ou M é ímpar, com interpolação linear entre as malhas) até ficar com
+// poucos intervalos, e o nível mais grosso é resolvido por SOR com ω ótimo.
+// Cada ciclo custa O(N·M), e o número de ciclos não cresce com a malha.
+// opt.precision escolhe a aritmética: em float o resíduo estaciona perto de
+// 1e-6; em precisão mista cada ciclo roda em float sobre o resíduo
+// calculado em double e corrige a solução em double, o que chega à precisão
+// do double com o custo por ciclo perto do float. O padrão é double: a
+// precisão mista só ganha quando a malha não cabe no cache (a partir de
+// 4096x2048 aqui); abaixo disso ela empata ou perde.
+SolverStats solveMultigrid(int N, int M, float *solution, const SolverOptions &opt);
+
+#endif
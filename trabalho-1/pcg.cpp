@@ -0,0 +1,197 @@
+#include "pcg.h"
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+// Operador A = -Δh no interior: (A u)ij = a uij - cx (u(i-1)j + u(i+1)j) - cy (ui(j-1) + ui(j+1)),
+// com os vizinhos de contorno já levados para b
+struct Stencil {
+	int nx, ny; // pontos interiores em x e y
+	double cx, cy, a;
+};
+
+// q = A p; devolve <p, q>
+double applyA(const Stencil &S, const std::vector<double> &p, std::vector<double> &q) {
+	const int nx = S.nx, ny = S.ny;
+	// linha de zeros no lugar dos vizinhos fora do interior
+	std::vector<double> zero(nx, 0.0);
+	double pq = 0.0;
+	for (int j = 0; j < ny; ++j) {
+		const double *pc = &p[size_t(j) * nx];
+		const double *pd = j > 0 ? pc - nx : zero.data();
+		const double *pu = j + 1 < ny ? pc + nx : zero.data();
+		double *qc = &q[size_t(j) * nx];
+		auto at = [&](int i, double x) {
+			qc[i] = S.a * pc[i] - S.cx * x - S.cy * (pd[i] + pu[i]);
+			pq += pc[i] * qc[i];
+		};
+		if (nx == 1) {
+			at(0, 0.0);
+			continue;
+		}
+		at(0, pc[1]);
+		for (int i = 1; i + 1 < nx; ++i)
+			at(i, pc[i - 1] + pc[i + 1]);
+		at(nx - 1, pc[nx - 2]);
+	}
+	return pq;
+}
+
+// Precondicionadores na forma M = (D + L) D^-1 (D + U), com L e U as partes
+// estritamente triangulares de A: no SSOR D = a/ω (constante), no IC(0) D é a
+// diagonal da fatoração incompleta. A aplicação é uma substituição para
+// frente e outra para trás, lexicográficas; `invd` guarda 1/D. Devolve <r, z>.
+double applyTriangular(const Stencil &S, const std::vector<double> &invd, const std::vector<double> &r,
+                       std::vector<double> &z) {
+	const int nx = S.nx, ny = S.ny;
+	for (int j = 0; j < ny; ++j) {
+		size_t row = size_t(j) * nx;
+		for (int i = 0; i < nx; ++i) {
+			double s = r[row + i];
+			if (i > 0)
+				s += S.cx * z[row + i - 1];
+			if (j > 0)
+				s += S.cy * z[row + i - nx];
+			z[row + i] = s * invd[row + i];
+		}
+	}
+	double rz = 0.0;
+	for (int j = ny - 1; j >= 0; --j) {
+		size_t row = size_t(j) * nx;
+		for (int i = nx - 1; i >= 0; --i) {
+			double s = 0.0;
+			if (i + 1 < nx)
+				s += S.cx * z[row + i + 1];
+			if (j + 1 < ny)
+				s += S.cy * z[row + i + nx];
+			z[row + i] += s * invd[row + i];
+			rz += r[row + i] * z[row + i];
+		}
+	}
+	return rz;
+}
+
+} // namespace
+
+SolverStats solvePCG(int N, int M, float *solution, const SolverOptions &opt) {
+	auto t0 = std::chrono::steady_clock::now();
+
+	Stencil S;
+	S.nx = N - 1;
+	S.ny = M - 1;
+	S.cx = N * N / (X_MAX * X_MAX);
+	S.cy = M * M / (Y_MAX * Y_MAX);
+	S.a = 2 * S.cx + 2 * S.cy;
+	const size_t n = size_t(S.nx) * S.ny;
+
+	// A = -Δh, logo b = -g
+	std::vector<double> b(n);
+	poissonRHS(N, M, b.data());
+	for (double &v : b)
+		v = -v;
+
+	// inversa da diagonal do precondicionador triangular
+	std::vector<double> d;
+	if (opt.preconditioner == Preconditioner::SSOR) {
+		double omega = 2.0 / (1.0 + std::sqrt(2.0 * (1.0 - jacobiRadius(N, M))));
+		d.assign(n, omega / S.a);
+	} else if (opt.preconditioner == Preconditioner::IC) {
+		d.resize(n);
+		for (int j = 0; j < S.ny; ++j)
+			for (int i = 0; i < S.nx; ++i) {
+				size_t k = i + size_t(j) * S.nx;
+				double v = S.a;
+				if (i > 0)
+					v -= S.cx * S.cx * d[k - 1];
+				if (j > 0)
+					v -= S.cy * S.cy * d[k - S.nx];
+				d[k] = 1.0 / v;
+			}
+	}
+
+	std::vector<double> x(n, 0.0), r(b), z(n), p(n), q(n);
+	double bb = 0.0;
+	for (double v : b)
+		bb += v * v;
+	const double bnorm = std::sqrt(bb);
+
+	SolverStats st;
+	st.residual = bnorm > 0.0 ? 1.0 : 0.0;
+	if (opt.warmStart && bnorm > 0.0) {
+		// r = b - A x0
+		for (size_t k = 0; k < n; ++k)
+			x[k] = solution[k];
+		applyA(S, x, q);
+		double rr = 0.0;
+		for (size_t k = 0; k < n; ++k) {
+			r[k] = b[k] - q[k];
+			rr += r[k] * r[k];
+		}
+		st.warmStart = true;
+		st.residual = st.initialResidual = std::sqrt(rr) / bnorm;
+	}
+
+	// sem precondicionador ou com Jacobi, M^-1 é uma escala e z sai na mesma
+	// passada que atualiza x e r
+	const bool triangular = !d.empty();
+	const double scale = opt.preconditioner == Preconditioner::Jacobi ? 1.0 / S.a : 1.0;
+
+	const int maxIterations = opt.maxIterations > 0 ? opt.maxIterations : 20 * (N + M);
+	double rz = 0.0;
+	if (triangular)
+		rz = applyTriangular(S, d, r, z);
+	else
+		for (size_t k = 0; k < n; ++k) {
+			z[k] = r[k] * scale;
+			rz += r[k] * z[k];
+		}
+	p = z;
+	while (st.residual > opt.tolerance && st.iterations < maxIterations) {
+		double alpha = rz / applyA(S, p, q);
+		double rr = 0.0, rzNew = 0.0;
+		if (triangular) {
+			for (size_t k = 0; k < n; ++k) {
+				x[k] += alpha * p[k];
+				r[k] -= alpha * q[k];
+				rr += r[k] * r[k];
+			}
+		} else {
+			for (size_t k = 0; k < n; ++k) {
+				x[k] += alpha * p[k];
+				r[k] -= alpha * q[k];
+				z[k] = r[k] * scale;
+				rr += r[k] * r[k];
+				rzNew += r[k] * z[k];
+			}
+		}
+		++st.iterations;
+		st.residual = std::sqrt(rr) / bnorm;
+		if (opt.monitor) {
+			if (float *snap = opt.monitor->snapshotBuffer(st.iterations, st.residual)) {
+				for (size_t k = 0; k < n; ++k)
+					snap[k] = float(x[k]);
+				opt.monitor->publish();
+			}
+			if (opt.monitor->cancelled()) {
+				st.cancelled = st.residual > opt.tolerance;
+				break;
+			}
+		}
+		if (st.residual <= opt.tolerance)
+			break;
+		if (triangular)
+			rzNew = applyTriangular(S, d, r, z);
+		double beta = rzNew / rz;
+		rz = rzNew;
+		for (size_t k = 0; k < n; ++k)
+			p[k] = z[k] + beta * p[k];
+	}
+
+	for (size_t k = 0; k < n; ++k)
+		solution[k] = float(x[k]);
+
+	st.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+	return st;
+}
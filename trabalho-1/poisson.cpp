@@ -0,0 +1,212 @@
+#include "poisson.h"
+#include "cholesky.h"
+#include "dst.h"
+#include "multigrid.h"
+#include "pcg.h"
+#include "sor.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+double poissonSource(double x, double y) {
+	return x * std::exp(y);
+}
+
+double boundaryValue(int i, int j, int N, int M) {
+	double x = i * (X_MAX / N);
+	double y = j * (Y_MAX / M);
+	if (i == 0)
+		return 0.0; // u(0,y) = 0
+	if (i == N)
+		return 2.0 * std::exp(y); // u(2,y) = 2e^y
+	if (j == 0)
+		return x; // u(x,0) = x
+	if (j == M)
+		return std::exp(x); // u(x,1) = e^x
+	return 0.0;
+}
+
+void poissonRHS(int N, int M, double *g, SourceFunction source, BoundaryFunction boundary) {
+	const double cx = N * N / (X_MAX * X_MAX), cy = M * M / (Y_MAX * Y_MAX);
+	for (int j = 1; j < M; ++j)
+		for (int i = 1; i < N; ++i) {
+			double v = source(i * (X_MAX / N), j * (Y_MAX / M));
+			if (i == 1)
+				v -= cx * boundary(0, j, N, M);
+			if (i == N - 1)
+				v -= cx * boundary(N, j, N, M);
+			if (j == 1)
+				v -= cy * boundary(i, 0, N, M);
+			if (j == M - 1)
+				v -= cy * boundary(i, M, N, M);
+			g[(i - 1) + size_t(j - 1) * (N - 1)] = v;
+		}
+}
+
+double relativeResidual(int N, int M, const double *u, const double *g) {
+	const int nx = N - 1, ny = M - 1;
+	const double cx = N * N / (X_MAX * X_MAX), cy = M * M / (Y_MAX * Y_MAX);
+	double rr = 0.0, gg = 0.0;
+	for (int j = 0; j < ny; ++j)
+		for (int i = 0; i < nx; ++i) {
+			size_t k = i + size_t(j) * nx;
+			double x = (i > 0 ? u[k - 1] : 0.0) + (i + 1 < nx ? u[k + 1] : 0.0);
+			double y = (j > 0 ? u[k - nx] : 0.0) + (j + 1 < ny ? u[k + nx] : 0.0);
+			double r = g[k] - cx * (x - 2 * u[k]) - cy * (y - 2 * u[k]);
+			rr += r * r;
+			gg += g[k] * g[k];
+		}
+	return gg > 0.0 ? std::sqrt(rr / gg) : 0.0;
+}
+
+namespace {
+
+struct SolverEntry {
+	const char *name;
+	SolverMethod method;
+};
+const SolverEntry SOLVERS[] = {
+    {"mg", SolverMethod::Multigrid},
+    {"pcg", SolverMethod::PCG},
+    {"sor", SolverMethod::SOR},
+    {"dst", SolverMethod::DST},
+    {"chol", SolverMethod::Cholesky},
+};
+
+const char *const PRECONDITIONERS[] = {"none", "jacobi", "ssor", "ic"};
+const char *const PRECISIONS[] = {"double", "float", "mixed"};
+
+} // namespace
+
+bool solverFromString(const char *name, SolverMethod &method) {
+	for (const SolverEntry &e : SOLVERS)
+		if (strcmp(name, e.name) == 0) {
+			method = e.method;
+			return true;
+		}
+	return false;
+}
+
+const char *solverName(SolverMethod method) {
+	for (const SolverEntry &e : SOLVERS)
+		if (e.method == method)
+			return e.name;
+	return "?";
+}
+
+bool preconditionerFromString(const char *name, Preconditioner &pc) {
+	for (int i = 0; i < 4; ++i)
+		if (strcmp(name, PRECONDITIONERS[i]) == 0) {
+			pc = Preconditioner(i);
+			return true;
+		}
+	return false;
+}
+
+const char *preconditionerName(Preconditioner pc) {
+	return PRECONDITIONERS[int(pc)];
+}
+
+bool precisionFromString(const char *name, Precision &precision) {
+	for (int i = 0; i < 3; ++i)
+		if (strcmp(name, PRECISIONS[i]) == 0) {
+			precision = Precision(i);
+			return true;
+		}
+	return false;
+}
+
+const char *precisionName(Precision precision) {
+	return PRECISIONS[int(precision)];
+}
+
+SolverStats solvePoisson(int N, int M, float *solution, const SolverOptions &opt) {
+	switch (opt.method) {
+	case SolverMethod::PCG:
+		return solvePCG(N, M, solution, opt);
+	case SolverMethod::SOR:
+		return solveSOR(N, M, solution, opt);
+	case SolverMethod::DST:
+		return solveDST(N, M, solution, opt);
+	case SolverMethod::Cholesky:
+		return solveCholesky(N, M, solution, opt);
+	case SolverMethod::Multigrid:
+	default:
+		return solveMultigrid(N, M, solution, opt);
+	}
+}
+
+double jacobiRadius(int N, int M) {
+	double cx = N * N / (X_MAX * X_MAX), cy = M * M / (Y_MAX * Y_MAX);
+	return (cx * std::cos(M_PI / N) + cy * std::cos(M_PI / M)) / (cx + cy);
+}
+
+double sorOmega(int N, int M) {
+	double rho = jacobiRadius(N, M);
+	return 2.0 / (1.0 + std::sqrt(1.0 - rho * rho));
+}
+
+namespace {
+
+// interpolação bilinear de old(i,j), na malha oldN x oldM, para os pontos
+// interiores da malha N x M; store(i, j, v) grava cada valor
+template <typename Old, typename Store> void interpolate(int oldN, int oldM, Old old, int N, int M, Store store) {
+	for (int j = 1; j < M; ++j) {
+		double y = double(j) * oldM / M;
+		int j0 = std::min(int(y), oldM - 1);
+		double ty = y - j0;
+		for (int i = 1; i < N; ++i) {
+			double x = double(i) * oldN / N;
+			int i0 = std::min(int(x), oldN - 1);
+			double tx = x - i0;
+			double v = (1 - ty) * ((1 - tx) * old(i0, j0) + tx * old(i0 + 1, j0)) +
+			           ty * ((1 - tx) * old(i0, j0 + 1) + tx * old(i0 + 1, j0 + 1));
+			store(i, j, float(v));
+		}
+	}
+}
+
+} // namespace
+
+void interpolateSolution(int oldN, int oldM, const float *oldSolution, int N, int M, float *solution) {
+	// valor do nó (i,j) da malha antiga, contorno incluído
+	auto old = [&](int i, int j) {
+		if (i > 0 && i < oldN && j > 0 && j < oldM)
+			return double(oldSolution[(i - 1) + (j - 1) * (oldN - 1)]);
+		return boundaryValue(i, j, oldN, oldM);
+	};
+	interpolate(oldN, oldM, old, N, M, [&](int i, int j, float v) { solution[(i - 1) + (j - 1) * (N - 1)] = v; });
+}
+
+void interpolateField(int oldN, int oldM, const float *oldField, int N, int M, float *field) {
+	auto old = [&](int i, int j) { return double(oldField[i + size_t(j) * (oldN + 1)]); };
+	interpolate(oldN, oldM, old, N, M, [&](int i, int j, float v) { field[i + size_t(j) * (N + 1)] = v; });
+}
+
+void setFieldBoundary(int N, int M, float *field) {
+	const size_t s = N + 1;
+	for (int i = 0; i <= N; ++i) {
+		field[i] = float(boundaryValue(i, 0, N, M));
+		field[i + M * s] = float(boundaryValue(i, M, N, M));
+	}
+	for (int j = 1; j < M; ++j) {
+		field[j * s] = float(boundaryValue(0, j, N, M));
+		field[N + j * s] = float(boundaryValue(N, j, N, M));
+	}
+}
+
+void setFieldInterior(int N, int M, const float *solution, float *field) {
+	for (int j = 1; j < M; ++j)
+		std::copy(solution + (j - 1) * size_t(N - 1), solution + j * size_t(N - 1), field + j * size_t(N + 1) + 1);
+}
+
+void getFieldInterior(int N, int M, const float *field, float *solution) {
+	for (int j = 1; j < M; ++j) {
+		const float *row = field + j * size_t(N + 1) + 1;
+		std::copy(row, row + N - 1, solution + (j - 1) * size_t(N - 1));
+	}
+}
+
+void SolPoisson(int N, int M, float *solution) {
+	solvePoisson(N, M, solution, SolverOptions());
+}
@@ -0,0 +1,122 @@
+#ifndef POISSON_H
+#define POISSON_H
+
+// Problema resolvido no trabalho:
+//   u_xx + u_yy = x e^y  em [0,2] x [0,1]
+//   u(0,y) = 0, u(2,y) = 2e^y, u(x,0) = x, u(x,1) = e^x
+// (com u(x,1) = e^x, e não e·x, x e^y não é a solução exata). A malha tem N
+// divisões em x e M em y, e a solução guarda só os pontos interiores, em
+// solution[(i-1) + (j-1)*(N-1)].
+
+const double X_MAX = 2.0;
+const double Y_MAX = 1.0;
+
+// termo fonte f(x,y)
+double poissonSource(double x, double y);
+// valor de contorno no nó (i,j) da borda da malha
+double boundaryValue(int i, int j, int N, int M);
+
+// Lado direito no layout interior: g = f - (contribuição dos vizinhos de
+// contorno), tal que Δh u = g nos pontos interiores. `source` e `boundary`
+// permitem montar outros dados na mesma malha.
+typedef double (*SourceFunction)(double x, double y);
+typedef double (*BoundaryFunction)(int i, int j, int N, int M);
+void poissonRHS(int N, int M, double *g, SourceFunction source = poissonSource,
+                BoundaryFunction boundary = boundaryValue);
+// ||g - Δh u|| / ||g|| para u e g no layout interior
+double relativeResidual(int N, int M, const double *u, const double *g);
+
+// raio espectral da iteração de Jacobi do laplaciano de 5 pontos na malha
+// N x M e o ω ótimo do SOR que sai dele
+double jacobiRadius(int N, int M);
+double sorOmega(int N, int M);
+
+enum class SolverMethod {
+	Multigrid, // multigrid geométrico (multigrid.h)
+	PCG,       // gradiente conjugado precondicionado sem matriz (pcg.h)
+	SOR,       // SOR vermelho-preto paralelo (sor.h)
+	DST,       // direto, por transformada seno (dst.h)
+	Cholesky,  // direto, Cholesky em banda com a fatoração em cache (cholesky.h)
+};
+
+enum class Preconditioner { None, Jacobi, SSOR, IC };
+
+// Aritmética do multigrid
+enum class Precision {
+	Double, // tudo em double
+	Float,  // tudo em float: metade do tráfego, mas o resíduo estaciona perto de 1e-6
+	Mixed,  // refinamento iterativo: resíduo e solução em double, correção por ciclo em float
+};
+
+// Acompanha um solver iterativo em andamento (solver_thread.h). Depois de
+// cada iteração o solver chama snapshotBuffer(); se receber um vetor, copia
+// nele o iterado atual no layout interior e chama publish(). Os métodos
+// diretos (DST e Cholesky) não publicam iterados, mas consultam cancelled():
+// o DST entre as etapas, o Cholesky ao longo da fatoração.
+class SolverMonitor {
+public:
+	virtual ~SolverMonitor() = default;
+	// vetor de (N-1)*(M-1) floats para a cópia, ou nullptr se não quer agora
+	virtual float *snapshotBuffer(int iteration, double residual) = 0;
+	virtual void publish() = 0;
+	// pedido para parar: o solver termina com o iterado atual
+	virtual bool cancelled() const = 0;
+};
+
+struct SolverOptions {
+	SolverMethod method = SolverMethod::Multigrid;
+	double tolerance = 1e-9; // resíduo relativo ||f - Au|| / ||f - Au0||, com u0 = 0 no interior
+	int maxIterations = 0; // 0 = limite padrão do método
+	int cycle = 1; // multigrid: 1 = ciclo V, 2 = ciclo W
+	int preSmooth = 2;
+	int postSmooth = 2;
+	Precision precision = Precision::Double; // multigrid
+	Preconditioner preconditioner = Preconditioner::SSOR; // PCG
+	int threads = 0; // SOR e DST: threads do OpenMP, 0 = todas
+	// Métodos iterativos: parte do conteúdo de `solution` em vez de zero.
+	// A tolerância continua relativa ao resíduo do chute zero, então um bom
+	// chute termina na mesma precisão com menos iterações.
+	bool warmStart = false;
+	SolverMonitor *monitor = nullptr; // métodos iterativos: recebe os iterados intermediários
+};
+
+struct SolverStats {
+	int iterations = 0;
+	double residual = 0.0; // resíduo relativo final
+	double initialResidual = 1.0; // resíduo relativo do chute inicial (1 sem partida a quente)
+	bool warmStart = false; // partiu de um chute
+	bool cancelled = false; // interrompido pelo monitor antes da tolerância
+	double seconds = 0.0;
+};
+
+// converte "mg", "pcg", "sor", "dst" ou "chol" (e "none", "jacobi", "ssor" ou "ic") para o valor correspondente
+bool solverFromString(const char *name, SolverMethod &method);
+const char *solverName(SolverMethod method);
+bool preconditionerFromString(const char *name, Preconditioner &pc);
+const char *preconditionerName(Preconditioner pc);
+// "double", "float" ou "mixed"
+bool precisionFromString(const char *name, Precision &precision);
+const char *precisionName(Precision precision);
+
+// resolve com o método de opt.method
+SolverStats solvePoisson(int N, int M, float *solution, const SolverOptions &opt);
+
+// Interpola bilinearmente a solução da malha oldN x oldM (contorno incluído)
+// nos pontos interiores da malha N x M; serve de chute inicial quando a
+// resolução muda, tanto para refinar quanto para engrossar.
+void interpolateSolution(int oldN, int oldM, const float *oldSolution, int N, int M, float *solution);
+
+// Campo completo: os (N+1)x(M+1) nós da malha, contorno incluído, em
+// field[i + j*(N+1)]. O contorno é calculado uma vez por malha, e quem
+// desenha ou percorre a solução lê só o vetor.
+void setFieldBoundary(int N, int M, float *field);
+void setFieldInterior(int N, int M, const float *solution, float *field);
+void getFieldInterior(int N, int M, const float *field, float *solution);
+// como interpolateSolution, mas do campo antigo para o interior de `field`
+void interpolateField(int oldN, int oldM, const float *oldField, int N, int M, float *field);
+
+// Resolve o problema na malha N x M por multigrid; mantém a assinatura da
+// antiga rotina do IM472.h
+void SolPoisson(int N, int M, float *solution);
+
+#endif
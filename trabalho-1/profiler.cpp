@@ -0,0 +1,59 @@
+#include "profiler.h"
+#include <cstdio>
+
+FrameProfiler::FrameProfiler() : frames(CAPACITY), origin(Clock::now()) {}
+
+void FrameProfiler::beginFrame() {
+	frameStart = lastMark = Clock::now();
+	Frame &f = frames[head];
+	f = Frame();
+	f.start = since(frameStart);
+}
+
+void FrameProfiler::mark(Stage s) {
+	Clock::time_point now = Clock::now();
+	frames[head].stage[s] += std::chrono::duration<double, std::milli>(now - lastMark).count();
+	lastMark = now;
+}
+
+void FrameProfiler::endFrame() {
+	frames[head].total = std::chrono::duration<double, std::milli>(Clock::now() - frameStart).count();
+	head = (head + 1) % CAPACITY;
+	if (count < CAPACITY)
+		++count;
+}
+
+double FrameProfiler::fps() const {
+	if (count < 2)
+		return 0.0;
+	const double end = at(count - 1).start;
+	int first = count - 1;
+	while (first > 0 && end - at(first - 1).start <= 1.0)
+		--first;
+	double span = end - at(first).start;
+	return span > 0.0 ? (count - 1 - first) / span : 0.0;
+}
+
+const char *FrameProfiler::stageName(Stage s) {
+	static const char *names[STAGES] = {"montagem", "desenho", "sobreposicao", "troca"};
+	return names[s];
+}
+
+bool FrameProfiler::writeCSV(const char *path) const {
+	FILE *out = fopen(path, "w");
+	if (!out)
+		return false;
+	fprintf(out, "inicio_s,total_ms");
+	for (int s = 0; s < STAGES; ++s)
+		fprintf(out, ",%s_ms", stageName(Stage(s)));
+	fprintf(out, ",N,M,vertices,triangulos,iteracao,residuo,solve_ms,resolvendo\n");
+	for (int k = 0; k < count; ++k) {
+		const Frame &f = at(k);
+		fprintf(out, "%.6f,%.4f", f.start, f.total);
+		for (double t : f.stage)
+			fprintf(out, ",%.4f", t);
+		fprintf(out, ",%d,%d,%ld,%ld,%d,%.6e,%.3f,%d\n", f.N, f.M, f.vertices, f.triangles, f.iteration, f.residual,
+		        f.solveMs, int(f.solving));
+	}
+	return fclose(out) == 0;
+}
@@ -0,0 +1,61 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <chrono>
+#include <vector>
+
+// Perfil por quadro do visualizador. Cada quadro guarda o tempo total e o
+// de cada etapa (montagem dos buffers, envio do desenho, sobreposição e
+// troca de buffers), o que foi desenhado e o estado do solver naquele
+// momento. Os últimos CAPACITY quadros ficam num buffer circular de tamanho
+// fixo, então medir não aloca nada depois da construção; writeCSV grava o
+// histórico para análise fora do programa.
+//
+// As etapas são medidas por marcas: mark(s) soma em s o tempo desde a marca
+// anterior (ou desde beginFrame). No OpenGL os comandos são assíncronos, e
+// o trabalho que o driver acumula costuma aparecer na troca de buffers.
+class FrameProfiler {
+public:
+	enum Stage { BUILD, DRAW, OVERLAY, SWAP, STAGES };
+	static const int CAPACITY = 1024;
+
+	struct Frame {
+		double start = 0.0; // s desde a criação do perfil
+		double total = 0.0; // ms
+		double stage[STAGES] = {}; // ms
+		int N = 0, M = 0;
+		long vertices = 0, triangles = 0; // enviados ao OpenGL
+		// solver: último iterado mostrado e tempo do solve (até agora, se
+		// ainda está rodando)
+		int iteration = 0;
+		double residual = 0.0, solveMs = 0.0;
+		bool solving = false;
+	};
+
+	FrameProfiler();
+
+	void beginFrame();
+	void mark(Stage s);
+	// quadro em medição, para preencher o que foi desenhado e o solver
+	Frame &current() { return frames[head]; }
+	void endFrame();
+
+	// quadros guardados; at(0) é o mais antigo
+	int size() const { return count; }
+	const Frame &at(int k) const { return frames[(head + CAPACITY - count + k) % CAPACITY]; }
+	// quadros por segundo no último segundo do histórico
+	double fps() const;
+
+	bool writeCSV(const char *path) const;
+	static const char *stageName(Stage s);
+
+private:
+	using Clock = std::chrono::steady_clock;
+	double since(Clock::time_point t) const { return std::chrono::duration<double>(t - origin).count(); }
+
+	std::vector<Frame> frames;
+	int head = 0, count = 0;
+	Clock::time_point origin, frameStart, lastMark;
+};
+
+#endif
@@ -0,0 +1,345 @@
+#include "raster.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <omp.h>
+
+namespace {
+
+// bit do plano próximo em ClipVertex::outcode
+const unsigned NEAR_PLANE = 1u << 4;
+
+// planos violados: x > w, x < -w, y > w, y < -w, z < -w (próximo), z > w
+unsigned outcode(const float p[4]) {
+	return unsigned(p[0] > p[3]) | unsigned(p[0] < -p[3]) << 1 | unsigned(p[1] > p[3]) << 2 |
+	       unsigned(p[1] < -p[3]) << 3 | unsigned(p[2] < -p[3]) << 4 | unsigned(p[2] > p[3]) << 5;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point t0) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+uint32_t crc32(const unsigned char *data, size_t n, uint32_t crc = 0) {
+	static uint32_t table[256];
+	if (!table[1])
+		for (uint32_t k = 0; k < 256; ++k) {
+			uint32_t c = k;
+			for (int b = 0; b < 8; ++b)
+				c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+			table[k] = c;
+		}
+	crc = ~crc;
+	for (size_t k = 0; k < n; ++k)
+		crc = table[(crc ^ data[k]) & 0xff] ^ (crc >> 8);
+	return ~crc;
+}
+
+void put32(std::vector<unsigned char> &out, uint32_t v) {
+	for (int s = 24; s >= 0; s -= 8)
+		out.push_back((unsigned char)(v >> s));
+}
+
+void writeChunk(FILE *f, const char *type, const std::vector<unsigned char> &data) {
+	std::vector<unsigned char> chunk;
+	put32(chunk, uint32_t(data.size()));
+	chunk.insert(chunk.end(), type, type + 4);
+	chunk.insert(chunk.end(), data.begin(), data.end());
+	put32(chunk, crc32(&chunk[4], chunk.size() - 4));
+	fwrite(chunk.data(), 1, chunk.size(), f);
+}
+
+} // namespace
+
+bool Image::writePPM(const char *path) const {
+	FILE *f = fopen(path, "wb");
+	if (!f)
+		return false;
+	fprintf(f, "P6\n%d %d\n255\n", width, height);
+	fwrite(rgb.data(), 1, rgb.size(), f);
+	return fclose(f) == 0;
+}
+
+bool Image::writePNG(const char *path) const {
+	FILE *f = fopen(path, "wb");
+	if (!f)
+		return false;
+	static const unsigned char signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+	fwrite(signature, 1, 8, f);
+
+	std::vector<unsigned char> header;
+	put32(header, width);
+	put32(header, height);
+	header.insert(header.end(), {8, 2, 0, 0, 0}); // 8 bits, RGB, sem entrelaçamento
+	writeChunk(f, "IHDR", header);
+
+	// linhas com filtro 0, num fluxo zlib de blocos sem compressão
+	std::vector<unsigned char> raw;
+	raw.reserve(size_t(height) * (3 * width + 1));
+	for (int y = 0; y < height; ++y) {
+		raw.push_back(0);
+		raw.insert(raw.end(), rgb.begin() + size_t(y) * 3 * width, rgb.begin() + size_t(y + 1) * 3 * width);
+	}
+	std::vector<unsigned char> z = {0x78, 0x01};
+	z.reserve(raw.size() + raw.size() / 65535 * 5 + 16);
+	for (size_t pos = 0; pos < raw.size() || pos == 0;) {
+		size_t len = std::min<size_t>(65535, raw.size() - pos);
+		bool last = pos + len == raw.size();
+		z.push_back(last ? 1 : 0);
+		z.push_back(len & 0xff);
+		z.push_back(len >> 8);
+		z.push_back(~len & 0xff);
+		z.push_back((~len >> 8) & 0xff);
+		z.insert(z.end(), raw.begin() + pos, raw.begin() + pos + len);
+		pos += len;
+		if (last)
+			break;
+	}
+	uint32_t a = 1, b = 0;
+	for (unsigned char c : raw) {
+		a = (a + c) % 65521;
+		b = (b + a) % 65521;
+	}
+	put32(z, (b << 16) | a);
+	writeChunk(f, "IDAT", z);
+	writeChunk(f, "IEND", {});
+	return fclose(f) == 0;
+}
+
+bool Image::write(const std::string &path) const {
+	if (path.size() >= 4 && path.compare(path.size() - 4, 4, ".ppm") == 0)
+		return writePPM(path.c_str());
+	return writePNG(path.c_str());
+}
+
+SoftwareRasterizer::SoftwareRasterizer(int width, int height) {
+	frame.width = width;
+	frame.height = height;
+	frame.rgb.assign(size_t(width) * height * 3, 0);
+	tilesX = (width + TILE - 1) / TILE;
+	tilesY = (height + TILE - 1) / TILE;
+}
+
+void SoftwareRasterizer::drawSurface(const PoissonGrid &g, const Colormap &colormap, float minValue,
+                                     float maxValue, const OrbitCamera &camera, bool lighting) {
+	auto t0 = std::chrono::steady_clock::now();
+	const int N = g.N(), M = g.M(), s = N + 1;
+	float mvp[16];
+	camera.matrix(float(frame.width) / frame.height, mvp);
+	// luz nas coordenadas da malha: n.l sem transformar as normais
+	float light[3];
+	camera.modelLight(light[0], light[1], light[2]);
+	const float ambient = OrbitCamera::GLOBAL_AMBIENT + OrbitCamera::LIGHT_AMBIENT;
+
+	vertices.resize(size_t(N + 1) * (M + 1));
+	const size_t threads = omp_get_max_threads();
+	if (triangles.size() < threads) {
+		triangles.resize(threads);
+		bins.resize(threads);
+	}
+	for (auto &t : triangles)
+		t.clear();
+	for (auto &b : bins) {
+		b.resize(size_t(tilesX) * tilesY);
+		for (auto &list : b)
+			list.clear();
+	}
+
+	const float *u = g.field().data();
+	const float range = maxValue > minValue ? maxValue - minValue : 1.0f;
+	double tTransform = 0.0, tSetup = 0.0;
+#pragma omp parallel
+	{
+		// 1. vértices (x, u, y), como no drawMesh
+#pragma omp for schedule(static)
+		for (int j = 0; j <= M; ++j)
+			for (int i = 0; i <= N; ++i) {
+				size_t k = i + size_t(j) * s;
+				float x, y;
+				g.getCoordinates(i, j, x, y);
+				ClipVertex &v = vertices[k];
+				for (int r = 0; r < 4; ++r)
+					v.p[r] = mvp[r] * x + mvp[4 + r] * u[k] + mvp[8 + r] * y + mvp[12 + r];
+				const unsigned char *rgb = colormap.color(Colormap::index((u[k] - minValue) / range));
+				float shade = 1.0f;
+				if (lighting) {
+					float n[3];
+					g.normal(i, j, n[0], n[1], n[2]);
+					const float d = n[0] * light[0] + n[1] * light[1] + n[2] * light[2];
+					shade = ambient + OrbitCamera::LIGHT_DIFFUSE * std::max(d, 0.0f);
+				}
+				for (int c = 0; c < 3; ++c)
+					v.c[c] = std::min(rgb[c] / 255.0f * shade, 1.0f);
+				v.outcode = outcode(v.p);
+				if (!(v.outcode & NEAR_PLANE))
+					project(v);
+			}
+#pragma omp master
+		tTransform = secondsSince(t0);
+
+		// 2. cada thread monta um bloco contíguo de colunas, na ordem das
+		// faixas do drawMesh: (i,j) (i+1,j) (i,j+1), depois (i+1,j) (i,j+1) (i+1,j+1)
+		const int t = omp_get_thread_num(), nt = omp_get_num_threads();
+		const int i0 = int(long(N) * t / nt), i1 = int(long(N) * (t + 1) / nt);
+		for (int i = i0; i < i1; ++i)
+			for (int j = 0; j < M; ++j) {
+				const ClipVertex *a = &vertices[i + size_t(j) * s], *b = a + s;
+				setupTriangle(a[0], a[1], b[0], t);
+				setupTriangle(a[1], b[0], b[1], t);
+			}
+#pragma omp barrier
+#pragma omp master
+		tSetup = secondsSince(t0);
+
+		// 3. ladrilhos
+#pragma omp for schedule(dynamic)
+		for (int tile = 0; tile < tilesX * tilesY; ++tile)
+			rasterTile(tile);
+	}
+
+	lastTiming.transform = tTransform;
+	lastTiming.setup = tSetup - tTransform;
+	lastTiming.raster = secondsSince(t0) - tSetup;
+	lastTiming.triangles = 0;
+	for (const auto &t : triangles)
+		lastTiming.triangles += long(t.size());
+}
+
+// divisão perspectiva e viewport; posição na tela com y para baixo,
+// arredondada a 1/256 de pixel
+void SoftwareRasterizer::project(ClipVertex &v) const {
+	v.iw = 1.0f / v.p[3];
+	v.sx = std::round((v.p[0] * v.iw + 1.0f) * 0.5f * frame.width * 256.0f) / 256.0f;
+	v.sy = std::round((1.0f - v.p[1] * v.iw) * 0.5f * frame.height * 256.0f) / 256.0f;
+	v.sz = v.p[2] * v.iw * 0.5f + 0.5f;
+}
+
+void SoftwareRasterizer::setupTriangle(const ClipVertex &a, const ClipVertex &b, const ClipVertex &c, int thread) {
+	// descarte trivial: os três vértices fora do mesmo plano do volume de visão
+	if (a.outcode & b.outcode & c.outcode)
+		return;
+	const ClipVertex *v[3] = {&a, &b, &c};
+	if (!((a.outcode | b.outcode | c.outcode) & NEAR_PLANE)) {
+		// caso comum: os vértices já foram projetados na etapa 1
+		emitTriangle(v, thread);
+		return;
+	}
+
+	// recorte no plano próximo (z >= -w), que dá um polígono de até 4 vértices
+	ClipVertex poly[4];
+	int count = 0;
+	for (int k = 0; k < 3; ++k) {
+		const ClipVertex &p = *v[k], &q = *v[(k + 1) % 3];
+		float dp = p.p[2] + p.p[3], dq = q.p[2] + q.p[3];
+		if (dp >= 0.0f)
+			poly[count++] = p;
+		if ((dp >= 0.0f) != (dq >= 0.0f)) {
+			float t = dp / (dp - dq);
+			ClipVertex &r = poly[count++];
+			for (int e = 0; e < 4; ++e)
+				r.p[e] = p.p[e] + t * (q.p[e] - p.p[e]);
+			for (int e = 0; e < 3; ++e)
+				r.c[e] = p.c[e] + t * (q.c[e] - p.c[e]);
+			project(r);
+		}
+	}
+	for (int k = 1; k + 1 < count; ++k) {
+		const ClipVertex *w[3] = {&poly[0], &poly[k], &poly[k + 1]};
+		emitTriangle(w, thread);
+	}
+}
+
+void SoftwareRasterizer::emitTriangle(const ClipVertex *const v[3], int thread) {
+	// orientação positiva, para as funções de aresta serem >= 0 dentro
+	double area = (double(v[1]->sx) - v[0]->sx) * (double(v[2]->sy) - v[0]->sy) -
+	              (double(v[1]->sy) - v[0]->sy) * (double(v[2]->sx) - v[0]->sx);
+	if (area == 0.0)
+		return;
+	const ClipVertex *w[3] = {v[0], v[1], v[2]};
+	if (area < 0.0) {
+		std::swap(w[1], w[2]);
+		area = -area;
+	}
+	Triangle T;
+	for (int e = 0; e < 3; ++e) {
+		T.x[e] = w[e]->sx;
+		T.y[e] = w[e]->sy;
+		T.z[e] = w[e]->sz;
+		T.iw[e] = w[e]->iw;
+		for (int ch = 0; ch < 3; ++ch)
+			T.c[e][ch] = w[e]->c[ch] * w[e]->iw;
+	}
+	// centros de pixel (p + 0.5) dentro da caixa do triângulo
+	T.x0 = std::max(0, int(std::ceil(std::min({T.x[0], T.x[1], T.x[2]}) - 0.5f)));
+	T.x1 = std::min(frame.width - 1, int(std::floor(std::max({T.x[0], T.x[1], T.x[2]}) - 0.5f)));
+	T.y0 = std::max(0, int(std::ceil(std::min({T.y[0], T.y[1], T.y[2]}) - 0.5f)));
+	T.y1 = std::min(frame.height - 1, int(std::floor(std::max({T.y[0], T.y[1], T.y[2]}) - 0.5f)));
+	if (T.x0 > T.x1 || T.y0 > T.y1)
+		return;
+	T.invArea = float(1.0 / area);
+
+	std::vector<Triangle> &list = triangles[thread];
+	unsigned index = unsigned(list.size());
+	list.push_back(T);
+	for (int ty = T.y0 / TILE; ty <= T.y1 / TILE; ++ty)
+		for (int tx = T.x0 / TILE; tx <= T.x1 / TILE; ++tx)
+			bins[thread][size_t(ty) * tilesX + tx].push_back(index);
+}
+
+void SoftwareRasterizer::rasterTile(int tile) {
+	const int tx = tile % tilesX, ty = tile / tilesX;
+	const int px0 = tx * TILE, py0 = ty * TILE;
+	const int px1 = std::min(px0 + TILE, frame.width) - 1, py1 = std::min(py0 + TILE, frame.height) - 1;
+	float depth[TILE * TILE];
+	unsigned char color[TILE * TILE * 3];
+	std::fill(depth, depth + TILE * TILE, 1.0f);
+	std::fill(color, color + TILE * TILE * 3, 0);
+
+	for (size_t t = 0; t < bins.size(); ++t)
+		for (unsigned index : bins[t][tile]) {
+			const Triangle &T = triangles[t][index];
+			const int x0 = std::max(T.x0, px0), x1 = std::min(T.x1, px1);
+			const int y0 = std::max(T.y0, py0), y1 = std::min(T.y1, py1);
+			// Funções de aresta E = A x + B y + C, positivas dentro. Com os
+			// vértices em 1/256 de pixel, as contas em double são exatas, e a
+			// regra de desempate (A > 0, ou A = 0 e B > 0) dá cada pixel sobre
+			// uma aresta comum a exatamente um dos dois triângulos.
+			double A[3], B[3], C[3];
+			bool owner[3];
+			for (int e = 0; e < 3; ++e) {
+				int p = (e + 1) % 3, q = (e + 2) % 3;
+				A[e] = -(double(T.y[q]) - T.y[p]);
+				B[e] = double(T.x[q]) - T.x[p];
+				C[e] = -(A[e] * T.x[p] + B[e] * T.y[p]);
+				owner[e] = A[e] > 0.0 || (A[e] == 0.0 && B[e] > 0.0);
+			}
+			for (int py = y0; py <= y1; ++py) {
+				double e[3];
+				for (int k = 0; k < 3; ++k)
+					e[k] = A[k] * (x0 + 0.5) + B[k] * (py + 0.5) + C[k];
+				float *zrow = &depth[(py - py0) * TILE];
+				unsigned char *crow = &color[(py - py0) * TILE * 3];
+				for (int px = x0; px <= x1; ++px, e[0] += A[0], e[1] += A[1], e[2] += A[2]) {
+					bool inside = (e[0] > 0.0 || (e[0] == 0.0 && owner[0])) && (e[1] > 0.0 || (e[1] == 0.0 && owner[1])) &&
+					              (e[2] > 0.0 || (e[2] == 0.0 && owner[2]));
+					if (!inside)
+						continue;
+					float l0 = float(e[0]) * T.invArea, l1 = float(e[1]) * T.invArea, l2 = float(e[2]) * T.invArea;
+					float z = l0 * T.z[0] + l1 * T.z[1] + l2 * T.z[2];
+					if (!(z < zrow[px - px0]))
+						continue;
+					zrow[px - px0] = z;
+					float w = 1.0f / (l0 * T.iw[0] + l1 * T.iw[1] + l2 * T.iw[2]);
+					for (int ch = 0; ch < 3; ++ch) {
+						float v = w * (l0 * T.c[0][ch] + l1 * T.c[1][ch] + l2 * T.c[2][ch]);
+						crow[3 * (px - px0) + ch] = (unsigned char)(std::min(std::max(v, 0.0f), 1.0f) * 255.0f + 0.5f);
+					}
+				}
+			}
+		}
+
+	for (int py = py0; py <= py1; ++py)
+		std::copy(&color[(py - py0) * TILE * 3], &color[((py - py0) * TILE + px1 - px0 + 1) * 3],
+		          &frame.rgb[(size_t(py) * frame.width + px0) * 3]);
+}
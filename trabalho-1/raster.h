@@ -0,0 +1,92 @@
+#ifndef RASTER_H
+#define RASTER_H
+
+#include "camera.h"
+#include "colormap.h"
+#include "grid.h"
+#include <string>
+#include <vector>
+
+// Imagem RGB de 8 bits, linhas de cima para baixo
+struct Image {
+	int width = 0, height = 0;
+	std::vector<unsigned char> rgb;
+
+	bool writePPM(const char *path) const;
+	// PNG sem compressão (blocos "stored" do deflate), sem depender da zlib
+	bool writePNG(const char *path) const;
+	// escolhe o formato pela extensão (.png ou .ppm)
+	bool write(const std::string &path) const;
+};
+
+// Rasterizador de triângulos na CPU, para desenhar a superfície sem OpenGL
+// nem janela. Produz a mesma imagem que o drawMesh do visualizador: as
+// mesmas faixas de triângulos entre as colunas i e i+1, as cores do mapa
+// iluminadas e interpoladas por vértice (Gouraud, com correção de
+// perspectiva como no OpenGL), teste de profundidade GL_LESS e a câmera e a
+// luz de OrbitCamera. A iluminação é a da GL_LIGHT0 do visualizador, com a
+// normal de PoissonGrid::normal.
+//
+// Cada quadro tem três etapas, todas divididas entre as threads do OpenMP:
+//   1. transformação dos (N+1)x(M+1) vértices para o espaço de recorte;
+//   2. montagem dos triângulos (recorte no plano próximo, descarte dos que
+//      não cobrem o centro de nenhum pixel) e distribuição em listas por
+//      ladrilho de TILE x TILE pixels; cada thread tem as suas listas, então
+//      esta etapa não tem disputa;
+//   3. rasterização, um ladrilho por vez em cada thread, com cor e
+//      profundidade locais (cabem no L1/L2) copiadas para a imagem no fim.
+// Os ladrilhos leem as listas das threads na ordem da malha, então a imagem
+// não depende do número de threads.
+class SoftwareRasterizer {
+public:
+	static const int TILE = 64;
+
+	SoftwareRasterizer(int width, int height);
+
+	// Desenha o campo da malha com as cores de `colormap` em [minValue, maxValue];
+	// sem `lighting`, só as cores do mapa, como com a tecla n do visualizador.
+	void drawSurface(const PoissonGrid &g, const Colormap &colormap, float minValue, float maxValue,
+	                 const OrbitCamera &camera, bool lighting = true);
+	const Image &image() const { return frame; }
+
+	// tempos da última chamada, em segundos
+	struct Timing {
+		double transform = 0.0, setup = 0.0, raster = 0.0;
+		long triangles = 0; // triângulos que chegaram às listas dos ladrilhos
+	};
+	const Timing &timing() const { return lastTiming; }
+
+	// triângulo já na tela, pronto para rasterizar
+	struct Triangle {
+		float x[3], y[3]; // posição na tela, em 1/256 de pixel
+		float z[3]; // profundidade em [0,1]
+		float iw[3]; // 1/w
+		float c[3][3]; // cor / w
+		float invArea;
+		int x0, y0, x1, y1; // pixels cobertos (inclusive)
+	};
+
+private:
+	// espaço de recorte: posição (x, y, z, w) e cor; se o vértice está na
+	// frente do plano próximo, também a projeção na tela (ver project)
+	struct ClipVertex {
+		float p[4];
+		float c[3];
+		float sx, sy, sz, iw;
+		unsigned outcode; // um bit por plano do volume de visão violado
+	};
+	void project(ClipVertex &v) const;
+	void setupTriangle(const ClipVertex &a, const ClipVertex &b, const ClipVertex &c, int thread);
+	void emitTriangle(const ClipVertex *const v[3], int thread);
+	void rasterTile(int tile);
+
+	Image frame;
+	int tilesX, tilesY;
+	std::vector<ClipVertex> vertices;
+	// por thread: triângulos montados e, por ladrilho, os índices deles
+	std::vector<std::vector<Triangle>> triangles;
+	std::vector<std::vector<std::vector<unsigned>>> bins;
+	Timing lastTiming;
+};
+
+#endif
@@ -0,0 +1,361 @@
+#include "cholesky.h"
+#include "poisson.h"
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <omp.h>
+#include <string>
+#include <vector>
+
+// Mede os solvers em malhas crescentes (N = 2M), ou só em N M dados na linha
+// de comando. O PCG roda com cada precondicionador, em malhas até 1024x512
+// (sem multigrid por trás, as iterações crescem com N); o SOR também.
+// "scaling" mede o SOR numa malha fixa (padrão 1024x512) de 1 thread até
+// todas, com aceleração e eficiência em relação a 1 thread. "verify" resolve
+// uma malha (padrão 256x128) pelo DST e compara os iterativos com ele.
+// "chol" mede a fatoração de Cholesky em banda, uma solução isolada e um lote
+// de 16 lados direitos resolvidos juntos ou um a um, contra o DST.
+// "warm" compara, em cada método iterativo, a solução a frio com a partida a
+// quente a partir da solução interpolada da malha com metade (e com o dobro)
+// da resolução, como acontece ao apertar + e - no visualizador.
+// "precision" roda o multigrid em double, em float e em precisão mista e
+// mostra a curva de convergência (resíduo por ciclo) de cada um.
+// Como o problema não tem solução exata conhecida, a coluna "dif. malha/2"
+// compara cada malha com a anterior nos nós comuns (média quadrática; o canto
+// (2,1), onde 2e^y e e^x não se encontram, domina a diferença máxima).
+// uso: ./solver_bench [mg|pcg|sor|dst|all|scaling|verify|chol|warm|precision] [N M]
+
+namespace {
+
+// diferença RMS entre a solução na malha N x M e na malha N/2 x M/2
+double coarseDifference(int N, int M, const std::vector<float> &fine, const std::vector<float> &coarse) {
+	int n = N / 2, m = M / 2;
+	double sum = 0.0;
+	for (int j = 1; j < m; ++j)
+		for (int i = 1; i < n; ++i) {
+			double d = double(fine[(2 * i - 1) + (2 * j - 1) * (N - 1)]) - coarse[(i - 1) + (j - 1) * (n - 1)];
+			sum += d * d;
+		}
+	return std::sqrt(sum / (double(n - 1) * (m - 1)));
+}
+
+struct Config {
+	std::string label;
+	SolverOptions opt;
+	int maxN;
+};
+
+void run(const Config &c, const std::vector<int> &sizes) {
+	std::vector<float> previous;
+	int prevN = 0, prevM = 0;
+	for (size_t s = 0; s + 1 < sizes.size(); s += 2) {
+		int N = sizes[s], M = sizes[s + 1];
+		if (N > c.maxN)
+			break;
+		long unknowns = long(N - 1) * (M - 1);
+		std::vector<float> solution(unknowns);
+		SolverStats st = solvePoisson(N, M, solution.data(), c.opt);
+		printf("%-10s %6d %6d %10ld %7d %10.2e %9.3f %12.1f", c.label.c_str(), N, M, unknowns, st.iterations,
+		       st.residual, st.seconds, st.seconds * 1e9 / unknowns);
+		if (prevN * 2 == N && prevM * 2 == M)
+			printf(" %12.2e", coarseDifference(N, M, solution, previous));
+		printf("\n");
+		fflush(stdout);
+		previous.swap(solution);
+		prevN = N;
+		prevM = M;
+	}
+}
+
+void scaling(int N, int M) {
+	printf("%7s %6s %6s %7s %9s %10s %10s\n", "threads", "N", "M", "iter.", "tempo(s)", "aceleração", "eficiência");
+	SolverOptions opt;
+	opt.method = SolverMethod::SOR;
+	std::vector<float> solution(size_t(N - 1) * (M - 1));
+	double t1 = 0.0;
+	int maxThreads = omp_get_max_threads();
+	for (int t = 1;; t = std::min(2 * t, maxThreads)) {
+		opt.threads = t;
+		SolverStats st = solvePoisson(N, M, solution.data(), opt);
+		if (t == 1)
+			t1 = st.seconds;
+		printf("%7d %6d %6d %7d %9.3f %10.2f %10.2f\n", t, N, M, st.iterations, st.seconds, t1 / st.seconds,
+		       t1 / st.seconds / t);
+		fflush(stdout);
+		if (t == maxThreads)
+			break;
+	}
+}
+
+void verify(int N, int M) {
+	std::vector<float> reference(size_t(N - 1) * (M - 1)), solution(reference.size());
+	SolverOptions opt;
+	opt.method = SolverMethod::DST;
+	SolverStats st = solvePoisson(N, M, reference.data(), opt);
+	printf("dst %dx%d: resíduo %.2e em %.3f s\n", N, M, st.residual, st.seconds);
+	printf("%-10s %7s %10s %12s\n", "método", "iter.", "resíduo", "dif. máx.");
+	std::vector<std::pair<std::string, SolverOptions>> runs;
+	for (SolverMethod m : {SolverMethod::Multigrid, SolverMethod::SOR}) {
+		opt.method = m;
+		runs.push_back({solverName(m), opt});
+	}
+	opt.method = SolverMethod::PCG;
+	for (Preconditioner pc : {Preconditioner::Jacobi, Preconditioner::SSOR, Preconditioner::IC}) {
+		opt.preconditioner = pc;
+		runs.push_back({std::string("pcg-") + preconditionerName(pc), opt});
+	}
+	for (const auto &run : runs) {
+		st = solvePoisson(N, M, solution.data(), run.second);
+		double diff = 0.0;
+		for (size_t k = 0; k < solution.size(); ++k)
+			diff = std::max(diff, std::fabs(double(solution[k]) - reference[k]));
+		printf("%-10s %7d %10.2e %12.2e\n", run.first.c_str(), st.iterations, st.residual, diff);
+	}
+}
+
+double secondsSince(std::chrono::steady_clock::time_point t0) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+void cholesky(const std::vector<int> &sizes, int maxN) {
+	const int nrhs = 16;
+	printf("%6s %6s %6s %9s %9s %11s %11s %9s %10s\n", "N", "M", "banda", "MiB", "fatorar", "1 lado dir.",
+	       "lote/lado", "1 a 1/lado", "dst/lado");
+	for (size_t s = 0; s + 1 < sizes.size(); s += 2) {
+		int N = sizes[s], M = sizes[s + 1];
+		if (N > maxN)
+			break;
+		const size_t n = size_t(N - 1) * (M - 1);
+		// lados direitos: o do problema e variações aleatórias dele
+		std::vector<double> g(n * nrhs), u(n * nrhs);
+		poissonRHS(N, M, g.data());
+		std::mt19937 rng(1);
+		std::uniform_real_distribution<double> noise(-1.0, 1.0);
+		for (int r = 1; r < nrhs; ++r)
+			for (size_t k = 0; k < n; ++k)
+				g[r * n + k] = g[k] + 10.0 * noise(rng);
+
+		auto t0 = std::chrono::steady_clock::now();
+		auto factor = choleskyFactor(N, M);
+		double tFactor = secondsSince(t0);
+
+		t0 = std::chrono::steady_clock::now();
+		factor->solve(g.data(), u.data(), 1);
+		double tOne = secondsSince(t0);
+
+		t0 = std::chrono::steady_clock::now();
+		factor->solve(g.data(), u.data(), nrhs);
+		double tBatch = secondsSince(t0) / nrhs;
+		double worst = 0.0;
+		for (int r = 0; r < nrhs; ++r)
+			worst = std::max(worst, relativeResidual(N, M, &u[r * n], &g[r * n]));
+
+		t0 = std::chrono::steady_clock::now();
+		for (int r = 0; r < nrhs; ++r)
+			factor->solve(&g[r * n], &u[r * n], 1);
+		double tSingle = secondsSince(t0) / nrhs;
+
+		std::vector<float> solution(n);
+		SolverOptions opt;
+		opt.method = SolverMethod::DST;
+		double tDst = solvePoisson(N, M, solution.data(), opt).seconds;
+
+		printf("%6d %6d %6d %9.1f %9.3f %11.4f %11.4f %9.4f %10.4f  (resíduo máx. %.1e)\n", N, M,
+		       factor->bandwidth(), factor->bytes() / 1048576.0, tFactor, tOne, tBatch, tSingle, tDst, worst);
+		fflush(stdout);
+	}
+}
+
+void warm(const std::vector<int> &sizes, int maxN) {
+	printf("%-5s %6s %6s %-8s %7s %9s %10s %9s %10s\n", "método", "N", "M", "origem", "iter.", "tempo(s)",
+	       "res. inic.", "economia", "tempo");
+	for (SolverMethod method : {SolverMethod::Multigrid, SolverMethod::PCG, SolverMethod::SOR}) {
+		for (size_t s = 2; s + 3 < sizes.size(); s += 2) {
+			int N = sizes[s], M = sizes[s + 1];
+			if (N > maxN || (method != SolverMethod::Multigrid && N > 512))
+				break;
+			SolverOptions opt;
+			opt.method = method;
+			std::vector<float> cold(size_t(N - 1) * (M - 1)), guess(cold.size());
+			SolverStats c = solvePoisson(N, M, cold.data(), opt);
+			printf("%-5s %6d %6d %-8s %7d %9.3f %10s %9s %10s\n", solverName(method), N, M, "frio", c.iterations,
+			       c.seconds, "1", "-", "-");
+			// de onde vem o chute: a malha com metade e com o dobro da resolução
+			const int from[2][2] = {{sizes[s - 2], sizes[s - 1]}, {sizes[s + 2], sizes[s + 3]}};
+			for (const auto &src : from) {
+				std::vector<float> previous(size_t(src[0] - 1) * (src[1] - 1));
+				SolverOptions srcOpt = opt;
+				srcOpt.method = SolverMethod::DST;
+				solvePoisson(src[0], src[1], previous.data(), srcOpt);
+				interpolateSolution(src[0], src[1], previous.data(), N, M, guess.data());
+				opt.warmStart = true;
+				SolverStats w = solvePoisson(N, M, guess.data(), opt);
+				char label[32];
+				snprintf(label, sizeof(label), "%dx%d", src[0], src[1]);
+				printf("%-5s %6d %6d %-8s %7d %9.3f %10.1e %8.0f%% %9.0f%%\n", solverName(method), N, M, label,
+				       w.iterations, w.seconds, w.initialResidual,
+				       100.0 * (c.iterations - w.iterations) / std::max(1, c.iterations),
+				       100.0 * (c.seconds - w.seconds) / c.seconds);
+			}
+			fflush(stdout);
+		}
+	}
+}
+
+// guarda o resíduo e o instante de cada iteração, sem pedir cópias
+class TraceMonitor : public SolverMonitor {
+public:
+	std::vector<double> residuals, seconds;
+	std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+
+	float *snapshotBuffer(int, double residual) override {
+		residuals.push_back(residual);
+		seconds.push_back(secondsSince(t0));
+		return nullptr;
+	}
+	void publish() override {}
+	bool cancelled() const override { return false; }
+};
+
+void precision(const std::vector<int> &sizes, int maxN) {
+	const Precision kinds[] = {Precision::Double, Precision::Float, Precision::Mixed};
+	for (size_t s = 0; s + 1 < sizes.size(); s += 2) {
+		int N = sizes[s], M = sizes[s + 1];
+		if (N > maxN)
+			break;
+		TraceMonitor trace[3];
+		SolverStats st[3];
+		// ms/ciclo vem do traço, sem a montagem do problema (que avalia
+		// e^y em todos os nós e pesa mais que um ciclo)
+		printf("%dx%d\n%-7s %7s %10s %9s %9s %11s %11s\n", N, M, "precisão", "ciclos", "resíduo", "tempo(s)",
+		       "ms/ciclo", "até 1e-6", "até 1e-9");
+		for (int p = 0; p < 3; ++p) {
+			SolverOptions opt;
+			opt.precision = kinds[p];
+			opt.maxIterations = 12; // o float estaciona; mais ciclos só repetem a linha
+			opt.monitor = &trace[p];
+			std::vector<float> solution(size_t(N - 1) * (M - 1));
+			trace[p].t0 = std::chrono::steady_clock::now();
+			st[p] = solvePoisson(N, M, solution.data(), opt);
+			const std::vector<double> &r = trace[p].residuals, &t = trace[p].seconds;
+			char reach[2][32];
+			const double targets[2] = {1e-6, 1e-9};
+			for (int g = 0; g < 2; ++g) {
+				size_t k = 0;
+				while (k < r.size() && r[k] > targets[g])
+					++k;
+				if (k < r.size())
+					snprintf(reach[g], sizeof(reach[g]), "%.3f", t[k]);
+				else
+					snprintf(reach[g], sizeof(reach[g]), "-");
+			}
+			double perCycle = t.size() > 1 ? (t.back() - t.front()) / (t.size() - 1) : 0.0;
+			printf("%-7s %7d %10.2e %9.3f %9.2f %11s %11s\n", precisionName(kinds[p]), st[p].iterations,
+			       st[p].residual, st[p].seconds, perCycle * 1e3, reach[0], reach[1]);
+		}
+		printf("%7s", "ciclo");
+		for (Precision p : kinds)
+			printf(" %10s", precisionName(p));
+		printf("\n");
+		size_t rows = 0;
+		for (const TraceMonitor &t : trace)
+			rows = std::max(rows, t.residuals.size());
+		for (size_t k = 0; k < rows; ++k) {
+			printf("%7zu", k + 1);
+			for (const TraceMonitor &t : trace)
+				if (k < t.residuals.size())
+					printf(" %10.2e", t.residuals[k]);
+				else
+					printf(" %10s", "");
+			printf("\n");
+		}
+		printf("\n");
+		fflush(stdout);
+	}
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+	const char *which = argc > 1 ? argv[1] : "all";
+	std::vector<int> sizes;
+	int maxN = 1 << 30;
+	if (argc > 3) {
+		sizes.push_back(atoi(argv[2]));
+		sizes.push_back(atoi(argv[3]));
+	} else {
+		for (int n = 64; n <= 4096; n *= 2) {
+			sizes.push_back(n);
+			sizes.push_back(n / 2);
+		}
+		maxN = 1024;
+	}
+
+	if (strcmp(which, "scaling") == 0) {
+		scaling(argc > 3 ? sizes[0] : 1024, argc > 3 ? sizes[1] : 512);
+		return 0;
+	}
+
+	if (strcmp(which, "verify") == 0) {
+		verify(argc > 3 ? sizes[0] : 256, argc > 3 ? sizes[1] : 128);
+		return 0;
+	}
+
+	if (strcmp(which, "chol") == 0) {
+		cholesky(sizes, argc > 3 ? maxN : 512);
+		return 0;
+	}
+
+	if (strcmp(which, "warm") == 0) {
+		warm(sizes, argc > 3 ? maxN : 2048);
+		return 0;
+	}
+
+	if (strcmp(which, "precision") == 0) {
+		precision(sizes, argc > 3 ? maxN : 4096);
+		return 0;
+	}
+
+	std::vector<Config> configs;
+	bool all = strcmp(which, "all") == 0;
+	if (all || strcmp(which, "mg") == 0) {
+		Config c{"mg-V", SolverOptions(), 1 << 30};
+		configs.push_back(c);
+		c.label = "mg-W";
+		c.opt.cycle = 2;
+		configs.push_back(c);
+	}
+	if (all || strcmp(which, "pcg") == 0) {
+		for (Preconditioner pc : {Preconditioner::None, Preconditioner::Jacobi, Preconditioner::SSOR,
+		                          Preconditioner::IC}) {
+			Config c{std::string("pcg-") + preconditionerName(pc), SolverOptions(), maxN};
+			c.opt.method = SolverMethod::PCG;
+			c.opt.preconditioner = pc;
+			configs.push_back(c);
+		}
+	}
+	if (all || strcmp(which, "sor") == 0) {
+		Config c{"sor", SolverOptions(), maxN};
+		c.opt.method = SolverMethod::SOR;
+		configs.push_back(c);
+	}
+	if (all || strcmp(which, "dst") == 0) {
+		Config c{"dst", SolverOptions(), 1 << 30};
+		c.opt.method = SolverMethod::DST;
+		configs.push_back(c);
+	}
+	if (configs.empty()) {
+		fprintf(stderr, "método desconhecido: %s\n", which);
+		return 1;
+	}
+
+	printf("%-10s %6s %6s %10s %7s %10s %9s %12s %12s\n", "método", "N", "M", "incógnitas", "iter.", "resíduo",
+	       "tempo(s)", "ns/incógnita", "dif. malha/2");
+	for (const Config &c : configs)
+		run(c, sizes);
+	return 0;
+}
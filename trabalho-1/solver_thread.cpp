@@ -0,0 +1,109 @@
+#include "solver_thread.h"
+#include <algorithm>
+
+void SolverThread::start(int N, int M, const SolverOptions &opt, const std::vector<float> &guess) {
+	cancel();
+	n = N;
+	m = M;
+	// a thread anterior terminou e a interface não está lendo: pode zerar
+	front.store(-1);
+	pending = -1;
+	stop.store(false);
+	running.store(true);
+	lastPublish = std::chrono::steady_clock::now();
+
+	SolverOptions o = opt;
+	o.monitor = this;
+	std::vector<float> work(size_t(N - 1) * (M - 1), 0.0f);
+	if (opt.warmStart && guess.size() == work.size())
+		work = guess;
+	else
+		o.warmStart = false;
+	worker = std::thread(&SolverThread::run, this, o, std::move(work));
+}
+
+void SolverThread::cancel() {
+	stop.store(true);
+	if (worker.joinable())
+		worker.join();
+	running.store(false);
+}
+
+int SolverThread::backBuffer() const {
+	int b = 1 - std::max(front.load(), 0);
+	return reading.load() == b ? -1 : b;
+}
+
+float *SolverThread::snapshotBuffer(int iteration, double residual) {
+	auto now = std::chrono::steady_clock::now();
+	if (std::chrono::duration<double>(now - lastPublish).count() < minInterval.load())
+		return nullptr;
+	// A interface só passa a ler um buffer depois de vê-lo em `front`, e
+	// `front` aponta para o outro; então o buffer escolhido aqui fica livre
+	// até publish().
+	pending = backBuffer();
+	if (pending < 0)
+		return nullptr;
+	SolverSnapshot &s = buffers[pending];
+	s.N = n;
+	s.M = m;
+	s.iteration = iteration;
+	s.residual = residual;
+	s.final = false;
+	s.solution.resize(size_t(n - 1) * (m - 1));
+	return s.solution.data();
+}
+
+void SolverThread::publish() {
+	buffers[pending].serial = ++serial;
+	front.store(pending);
+	pending = -1;
+	lastPublish = std::chrono::steady_clock::now();
+}
+
+void SolverThread::run(SolverOptions opt, std::vector<float> work) {
+	SolverStats st = solvePoisson(n, m, work.data(), opt);
+	if (!stop.load()) {
+		int b;
+		while ((b = backBuffer()) < 0)
+			std::this_thread::yield();
+		SolverSnapshot &s = buffers[b];
+		s.N = n;
+		s.M = m;
+		s.iteration = st.iterations;
+		s.residual = st.residual;
+		s.final = true;
+		s.stats = st;
+		s.solution.swap(work);
+		pending = b;
+		publish();
+	}
+	running.store(false);
+}
+
+bool SolverThread::latest(SolverSnapshot &out) {
+	int f;
+	// anuncia o buffer e confirma que ele ainda é o publicado; se o solver
+	// trocou `front` no meio, tenta de novo com o novo
+	do {
+		f = front.load();
+		if (f < 0)
+			return false;
+		reading.store(f);
+	} while (front.load() != f);
+
+	const SolverSnapshot &s = buffers[f];
+	bool fresh = s.serial > out.serial;
+	if (fresh) {
+		out.N = s.N;
+		out.M = s.M;
+		out.iteration = s.iteration;
+		out.residual = s.residual;
+		out.final = s.final;
+		out.stats = s.stats;
+		out.serial = s.serial;
+		out.solution.assign(s.solution.begin(), s.solution.end());
+	}
+	reading.store(-1);
+	return fresh;
+}
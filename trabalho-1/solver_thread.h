@@ -0,0 +1,73 @@
+#ifndef SOLVER_THREAD_H
+#define SOLVER_THREAD_H
+
+#include "poisson.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+// Iterado publicado pela thread do solver
+struct SolverSnapshot {
+	int N = 0, M = 0;
+	int iteration = 0;
+	double residual = 1.0;
+	bool final = false; // resultado do solve; `stats` só vale neste caso
+	SolverStats stats;
+	unsigned long serial = 0; // cresce a cada publicação
+	std::vector<float> solution; // layout interior
+};
+
+// Roda solvePoisson numa thread de trabalho e publica os iterados
+// intermediários, no máximo um a cada interval() segundos, mais a solução
+// final. A entrega é por buffer duplo sem trava: o solver escreve no buffer
+// que não é o publicado e troca o índice `front` atomicamente; a interface
+// anuncia em `reading` o buffer que está copiando, e o solver descarta o
+// iterado da vez em vez de esperar por ela. Só a solução final, que não pode
+// se perder, espera a cópia em andamento terminar.
+class SolverThread : private SolverMonitor {
+public:
+	SolverThread() = default;
+	~SolverThread() { cancel(); }
+	SolverThread(const SolverThread &) = delete;
+	SolverThread &operator=(const SolverThread &) = delete;
+
+	// Começa a resolver na malha N x M, interrompendo o solve anterior.
+	// `guess` (layout interior) é o chute inicial se opt.warmStart.
+	void start(int N, int M, const SolverOptions &opt, const std::vector<float> &guess);
+	// interrompe o solve em andamento e espera a thread terminar
+	void cancel();
+	bool busy() const { return running.load(); }
+
+	// intervalo mínimo entre iterados publicados; 0 publica todos
+	void setInterval(double seconds) { minInterval.store(seconds); }
+	double interval() const { return minInterval.load(); }
+
+	// Copia para `out` o último iterado publicado, se for mais novo que
+	// out.serial. Só a thread da interface chama start(), cancel() e latest().
+	bool latest(SolverSnapshot &out);
+
+private:
+	float *snapshotBuffer(int iteration, double residual) override;
+	void publish() override;
+	bool cancelled() const override { return stop.load(std::memory_order_relaxed); }
+
+	void run(SolverOptions opt, std::vector<float> work);
+	// buffer livre para a próxima publicação, ou -1 se a interface está nele
+	int backBuffer() const;
+
+	std::thread worker;
+	std::atomic<bool> stop{false}, running{false};
+	std::atomic<double> minInterval{0.1};
+
+	SolverSnapshot buffers[2];
+	std::atomic<int> front{-1}; // último buffer publicado (-1 = nenhum)
+	std::atomic<int> reading{-1}; // buffer que a interface está copiando
+	// estado da thread de trabalho
+	int n = 0, m = 0;
+	int pending = -1; // buffer entregue por snapshotBuffer() e ainda não publicado
+	unsigned long serial = 0;
+	std::chrono::steady_clock::time_point lastPublish;
+};
+
+#endif
@@ -0,0 +1,102 @@
+#include "sor.h"
+#include <chrono>
+#include <cmath>
+#include <omp.h>
+#include <vector>
+
+SolverStats solveSOR(int N, int M, float *solution, const SolverOptions &opt) {
+	auto t0 = std::chrono::steady_clock::now();
+
+	// malha completa com o contorno, como no multigrid
+	const int s = N + 1;
+	std::vector<double> u(size_t(s) * (M + 1)), f(u.size());
+	for (int j = 0; j <= M; ++j)
+		for (int i = 0; i <= N; ++i) {
+			bool border = i == 0 || i == N || j == 0 || j == M;
+			u[i + size_t(j) * s] = border ? boundaryValue(i, j, N, M) : 0.0;
+			f[i + size_t(j) * s] = poissonSource(i * (X_MAX / N), j * (Y_MAX / M));
+		}
+
+	// referência da tolerância: resíduo do chute zero, ||g||
+	double r0 = 0.0;
+	{
+		std::vector<double> g(size_t(N - 1) * (M - 1));
+		poissonRHS(N, M, g.data());
+		for (double v : g)
+			r0 += v * v;
+		r0 = std::sqrt(r0);
+	}
+	SolverStats st;
+	if (opt.warmStart && r0 > 0.0) {
+		for (int j = 1; j < M; ++j)
+			for (int i = 1; i < N; ++i)
+				u[i + size_t(j) * s] = solution[(i - 1) + (j - 1) * (N - 1)];
+		st.warmStart = true;
+	}
+
+	const double cx = N * N / (X_MAX * X_MAX), cy = M * M / (Y_MAX * Y_MAX);
+	const double diag = 1.0 / (2 * cx + 2 * cy);
+	const double omega = sorOmega(N, M);
+	const int maxIterations = opt.maxIterations > 0 ? opt.maxIterations : 50 * (N + M);
+	// o resíduo custa uma varredura; é medido a cada `check` iterações
+	const int check = 10;
+	const int threads = opt.threads > 0 ? opt.threads : omp_get_max_threads();
+
+	double sum = 0.0;
+	bool done = false;
+#pragma omp parallel num_threads(threads)
+	for (int it = 0; !done; ++it) {
+		if (it % check == 0) {
+#pragma omp single
+			sum = 0.0;
+#pragma omp for reduction(+ : sum)
+			for (int j = 1; j < M; ++j) {
+				const double *uc = &u[size_t(j) * s], *fc = &f[size_t(j) * s];
+				for (int i = 1; i < N; ++i) {
+					double r = fc[i] - cx * (uc[i - 1] - 2 * uc[i] + uc[i + 1]) - cy * (uc[i - s] - 2 * uc[i] + uc[i + s]);
+					sum += r * r;
+				}
+			}
+			// a barreira implícita do `for` garante que todas veem o mesmo `sum`
+#pragma omp single
+			{
+				st.residual = r0 > 0.0 ? std::sqrt(sum) / r0 : 0.0;
+				if (it == 0 && st.warmStart)
+					st.initialResidual = st.residual;
+				st.iterations = it;
+				done = st.residual <= opt.tolerance || it >= maxIterations;
+				// o iterado só é publicado junto com o resíduo, a cada `check` varreduras
+				if (opt.monitor && it > 0) {
+					if (float *snap = opt.monitor->snapshotBuffer(it, st.residual)) {
+						for (int j = 1; j < M; ++j)
+							for (int i = 1; i < N; ++i)
+								snap[(i - 1) + (j - 1) * (N - 1)] = float(u[i + size_t(j) * s]);
+						opt.monitor->publish();
+					}
+					if (!done && opt.monitor->cancelled())
+						done = st.cancelled = true;
+				}
+			}
+			if (done)
+				break;
+		}
+		for (int color = 0; color < 2; ++color) {
+#pragma omp for schedule(static)
+			for (int j = 1; j < M; ++j) {
+				double *uc = &u[size_t(j) * s];
+				const double *fc = &f[size_t(j) * s];
+				for (int i = 1 + (j + color + 1) % 2; i < N; i += 2) {
+					double gs = (cx * (uc[i - 1] + uc[i + 1]) + cy * (uc[i - s] + uc[i + s]) - fc[i]) * diag;
+					uc[i] += omega * (gs - uc[i]);
+				}
+			}
+		}
+	}
+
+	for (int j = 1; j < M; ++j)
+		for (int i = 1; i < N; ++i)
+			solution[(i - 1) + (j - 1) * (N - 1)] = float(u[i + size_t(j) * s]);
+
+	st.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+	return st;
+}
@@ -0,0 +1,11 @@
+#ifndef SOR_H
+#define SOR_H
+
+#include "poisson.h"
+
+// SOR vermelho-preto com o ω ótimo analítico do retângulo. Dentro de cada
+// cor os pontos são independentes, então as linhas de cada meia varredura
+// são divididas entre as threads do OpenMP (opt.threads; 0 = todas).
+SolverStats solveSOR(int N, int M, float *solution, const SolverOptions &opt);
+
+#endif
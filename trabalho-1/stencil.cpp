@@ -0,0 +1,231 @@
+#include "stencil.h"
+#include <algorithm>
+#include <cstring>
+#include <immintrin.h>
+
+namespace {
+
+struct Coeffs {
+	double cx, cy, a, diag, omega;
+};
+
+Coeffs coeffs(const StencilGrid &g, double omega) {
+	double a = 2 * g.cx + 2 * g.cy;
+	return {g.cx, g.cy, a, 1.0 / a, omega};
+}
+
+// Núcleos de uma linha, pontos i0 <= i < i1: s, c e n são as linhas j-1, j e
+// j+1 de u, começando na coluna 0.
+
+void jacobiRowScalar(const double *s, const double *c, const double *n, const double *f, double *out, int i0,
+                     int i1, const Coeffs &k) {
+	for (int i = i0; i < i1; ++i) {
+		double gs = (k.cx * (c[i - 1] + c[i + 1]) + k.cy * (s[i] + n[i]) - f[i]) * k.diag;
+		out[i] = c[i] + k.omega * (gs - c[i]);
+	}
+}
+
+double residualRowScalar(const double *s, const double *c, const double *n, const double *f, double *r, int i0,
+                         int i1, const Coeffs &k) {
+	double sum = 0.0;
+	for (int i = i0; i < i1; ++i) {
+		double v = f[i] - (k.cx * (c[i - 1] + c[i + 1]) + k.cy * (s[i] + n[i]) - k.a * c[i]);
+		r[i] = v;
+		sum += v * v;
+	}
+	return sum;
+}
+
+__attribute__((target("avx2,fma"))) void jacobiRowAVX2(const double *s, const double *c, const double *n,
+                                                         const double *f, double *out, int i0, int i1,
+                                                         const Coeffs &k) {
+	const __m256d cx = _mm256_set1_pd(k.cx), cy = _mm256_set1_pd(k.cy), diag = _mm256_set1_pd(k.diag),
+	              omega = _mm256_set1_pd(k.omega);
+	int i = i0;
+	for (; i + 4 <= i1; i += 4) {
+		__m256d uc = _mm256_loadu_pd(c + i);
+		__m256d x = _mm256_add_pd(_mm256_loadu_pd(c + i - 1), _mm256_loadu_pd(c + i + 1));
+		__m256d y = _mm256_add_pd(_mm256_loadu_pd(s + i), _mm256_loadu_pd(n + i));
+		__m256d t = _mm256_fmadd_pd(cy, y, _mm256_fmsub_pd(cx, x, _mm256_loadu_pd(f + i)));
+		__m256d gs = _mm256_mul_pd(t, diag);
+		_mm256_storeu_pd(out + i, _mm256_fmadd_pd(omega, _mm256_sub_pd(gs, uc), uc));
+	}
+	jacobiRowScalar(s, c, n, f, out, i, i1, k);
+}
+
+__attribute__((target("avx2,fma"))) double residualRowAVX2(const double *s, const double *c, const double *n,
+                                                             const double *f, double *r, int i0, int i1,
+                                                             const Coeffs &k) {
+	const __m256d cx = _mm256_set1_pd(k.cx), cy = _mm256_set1_pd(k.cy), a = _mm256_set1_pd(k.a);
+	__m256d acc = _mm256_setzero_pd();
+	int i = i0;
+	for (; i + 4 <= i1; i += 4) {
+		__m256d uc = _mm256_loadu_pd(c + i);
+		__m256d x = _mm256_add_pd(_mm256_loadu_pd(c + i - 1), _mm256_loadu_pd(c + i + 1));
+		__m256d y = _mm256_add_pd(_mm256_loadu_pd(s + i), _mm256_loadu_pd(n + i));
+		__m256d lap = _mm256_fmadd_pd(cy, y, _mm256_fmsub_pd(cx, x, _mm256_mul_pd(a, uc)));
+		__m256d v = _mm256_sub_pd(_mm256_loadu_pd(f + i), lap);
+		_mm256_storeu_pd(r + i, v);
+		acc = _mm256_fmadd_pd(v, v, acc);
+	}
+	double lanes[4];
+	_mm256_storeu_pd(lanes, acc);
+	return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + residualRowScalar(s, c, n, f, r, i, i1, k);
+}
+
+__attribute__((target("avx512f"))) void jacobiRowAVX512(const double *s, const double *c, const double *n,
+                                                          const double *f, double *out, int i0, int i1,
+                                                          const Coeffs &k) {
+	const __m512d cx = _mm512_set1_pd(k.cx), cy = _mm512_set1_pd(k.cy), diag = _mm512_set1_pd(k.diag),
+	              omega = _mm512_set1_pd(k.omega);
+	int i = i0;
+	for (; i + 8 <= i1; i += 8) {
+		__m512d uc = _mm512_loadu_pd(c + i);
+		__m512d x = _mm512_add_pd(_mm512_loadu_pd(c + i - 1), _mm512_loadu_pd(c + i + 1));
+		__m512d y = _mm512_add_pd(_mm512_loadu_pd(s + i), _mm512_loadu_pd(n + i));
+		__m512d t = _mm512_fmadd_pd(cy, y, _mm512_fmsub_pd(cx, x, _mm512_loadu_pd(f + i)));
+		__m512d gs = _mm512_mul_pd(t, diag);
+		_mm512_storeu_pd(out + i, _mm512_fmadd_pd(omega, _mm512_sub_pd(gs, uc), uc));
+	}
+	// resto com máscara em vez do laço escalar
+	if (i < i1) {
+		__mmask8 m = __mmask8((1u << (i1 - i)) - 1);
+		__m512d uc = _mm512_maskz_loadu_pd(m, c + i);
+		__m512d x = _mm512_add_pd(_mm512_maskz_loadu_pd(m, c + i - 1), _mm512_maskz_loadu_pd(m, c + i + 1));
+		__m512d y = _mm512_add_pd(_mm512_maskz_loadu_pd(m, s + i), _mm512_maskz_loadu_pd(m, n + i));
+		__m512d t = _mm512_fmadd_pd(cy, y, _mm512_fmsub_pd(cx, x, _mm512_maskz_loadu_pd(m, f + i)));
+		__m512d gs = _mm512_mul_pd(t, diag);
+		_mm512_mask_storeu_pd(out + i, m, _mm512_fmadd_pd(omega, _mm512_sub_pd(gs, uc), uc));
+	}
+}
+
+__attribute__((target("avx512f"))) double residualRowAVX512(const double *s, const double *c, const double *n,
+                                                              const double *f, double *r, int i0, int i1,
+                                                              const Coeffs &k) {
+	const __m512d cx = _mm512_set1_pd(k.cx), cy = _mm512_set1_pd(k.cy), a = _mm512_set1_pd(k.a);
+	__m512d acc = _mm512_setzero_pd();
+	for (int i = i0; i < i1; i += 8) {
+		__mmask8 m = i1 - i >= 8 ? __mmask8(0xff) : __mmask8((1u << (i1 - i)) - 1);
+		__m512d uc = _mm512_maskz_loadu_pd(m, c + i);
+		__m512d x = _mm512_add_pd(_mm512_maskz_loadu_pd(m, c + i - 1), _mm512_maskz_loadu_pd(m, c + i + 1));
+		__m512d y = _mm512_add_pd(_mm512_maskz_loadu_pd(m, s + i), _mm512_maskz_loadu_pd(m, n + i));
+		__m512d lap = _mm512_fmadd_pd(cy, y, _mm512_fmsub_pd(cx, x, _mm512_mul_pd(a, uc)));
+		__m512d v = _mm512_sub_pd(_mm512_maskz_loadu_pd(m, f + i), lap);
+		_mm512_mask_storeu_pd(r + i, m, v);
+		acc = _mm512_fmadd_pd(v, v, acc);
+	}
+	double lanes[8];
+	_mm512_storeu_pd(lanes, acc);
+	return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+}
+
+struct RowKernels {
+	void (*jacobi)(const double *, const double *, const double *, const double *, double *, int, int,
+	               const Coeffs &);
+	double (*residual)(const double *, const double *, const double *, const double *, double *, int, int,
+	                   const Coeffs &);
+};
+
+const RowKernels KERNELS[] = {
+    {jacobiRowScalar, residualRowScalar},
+    {jacobiRowAVX2, residualRowAVX2},
+    {jacobiRowAVX512, residualRowAVX512},
+};
+
+StencilIsa detectIsa() {
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f"))
+		return StencilIsa::AVX512;
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+		return StencilIsa::AVX2;
+	return StencilIsa::Scalar;
+}
+
+const StencilIsa bestIsa = detectIsa();
+StencilIsa currentIsa = bestIsa;
+
+const RowKernels &kernels() {
+	return KERNELS[int(currentIsa)];
+}
+
+} // namespace
+
+StencilIsa stencilBestIsa() {
+	return bestIsa;
+}
+
+StencilIsa stencilIsa() {
+	return currentIsa;
+}
+
+void stencilSetIsa(StencilIsa isa) {
+	currentIsa = std::min(isa, bestIsa);
+}
+
+const char *stencilIsaName(StencilIsa isa) {
+	switch (isa) {
+	case StencilIsa::AVX512:
+		return "avx512";
+	case StencilIsa::AVX2:
+		return "avx2";
+	default:
+		return "escalar";
+	}
+}
+
+void stencilJacobi(const StencilGrid &g, const double *u, const double *f, double *out, double omega,
+                   int blockWidth) {
+	const Coeffs k = coeffs(g, omega);
+	const RowKernels &kr = kernels();
+	const int width = blockWidth > 0 ? blockWidth : g.n;
+	for (int i0 = 1; i0 < g.n; i0 += width) {
+		const int i1 = std::min(g.n, i0 + width);
+		for (int j = 1; j < g.m; ++j) {
+			const double *c = u + j * g.stride;
+			kr.jacobi(c - g.stride, c, c + g.stride, f + j * g.stride, out + j * g.stride, i0, i1, k);
+		}
+	}
+}
+
+void stencilJacobiSweeps(const StencilGrid &g, double *u, double *tmp, const double *f, double omega, int sweeps) {
+	if (sweeps <= 0)
+		return;
+	const Coeffs k = coeffs(g, omega);
+	const RowKernels &kr = kernels();
+	const std::ptrdiff_t s = g.stride;
+
+	// contorno de u em tmp: a linha 0 e a m inteiras, e as colunas 0 e n
+	std::memcpy(tmp, u, sizeof(double) * (g.n + 1));
+	std::memcpy(tmp + g.m * s, u + g.m * s, sizeof(double) * (g.n + 1));
+	for (int j = 1; j < g.m; ++j) {
+		tmp[j * s] = u[j * s];
+		tmp[j * s + g.n] = u[j * s + g.n];
+	}
+
+	// A varredura t lê buf[t % 2] e escreve buf[(t+1) % 2]. No passo r ela
+	// calcula a linha r - t, depois de a varredura t-1 ter calculado a linha
+	// r - t + 1; com isso cada linha sobrescrita já foi lida por quem precisava.
+	double *buf[2] = {u, tmp};
+	for (int r = 1; r < g.m + sweeps - 1; ++r)
+		for (int t = 0; t < sweeps; ++t) {
+			const int j = r - t;
+			if (j < 1 || j >= g.m)
+				continue;
+			const double *c = buf[t % 2] + j * s;
+			kr.jacobi(c - s, c, c + s, f + j * s, buf[(t + 1) % 2] + j * s, 1, g.n, k);
+		}
+	if (sweeps % 2)
+		for (int j = 1; j < g.m; ++j)
+			std::memcpy(u + j * s + 1, tmp + j * s + 1, sizeof(double) * (g.n - 1));
+}
+
+double stencilResidual(const StencilGrid &g, const double *u, const double *f, double *r) {
+	const Coeffs k = coeffs(g, 1.0);
+	const RowKernels &kr = kernels();
+	double sum = 0.0;
+	for (int j = 1; j < g.m; ++j) {
+		const double *c = u + j * g.stride;
+		sum += kr.residual(c - g.stride, c, c + g.stride, f + j * g.stride, r + j * g.stride, 1, g.n, k);
+	}
+	return sum;
+}
@@ -0,0 +1,46 @@
+#ifndef STENCIL_H
+#define STENCIL_H
+
+#include <cstddef>
+
+// Núcleos do estêncil de 5 pontos sobre a malha completa (n+1)x(m+1), com o
+// contorno guardado junto (como no multigrid e no SOR): a linha j começa em
+// j*stride e só os pontos 1..n-1 x 1..m-1 são atualizados. Cada núcleo tem
+// versões escalar, AVX2 e AVX-512; a versão usada é escolhida em tempo de
+// execução pelo processador (stencilIsa), e pode ser forçada para comparar.
+struct StencilGrid {
+	int n, m;
+	std::ptrdiff_t stride;
+	double cx, cy; // 1/h² e 1/k²
+};
+
+enum class StencilIsa { Scalar, AVX2, AVX512 };
+
+StencilIsa stencilBestIsa(); // a melhor que o processador suporta
+StencilIsa stencilIsa(); // a em uso
+// força uma versão; pedidos acima de stencilBestIsa() ficam na melhor suportada
+void stencilSetIsa(StencilIsa isa);
+const char *stencilIsaName(StencilIsa isa);
+
+// Uma varredura de Jacobi amortecida para Δh u = f:
+//   out = u + ω (((cx (uO + uL) + cy (uS + uN) - f) / (2cx + 2cy)) - u)
+// com bloqueio espacial em faixas de `blockWidth` colunas (0 = linha
+// inteira), para as três linhas de u que cada ponto lê ficarem no cache.
+void stencilJacobi(const StencilGrid &g, const double *u, const double *f, double *out, double omega,
+                   int blockWidth = 0);
+
+// `sweeps` varreduras de Jacobi com bloqueio temporal: as varreduras avançam
+// juntas em frente de onda, a varredura t na linha r - t, então cada linha é
+// trazida da memória uma vez para todas as varreduras enquanto as ~sweeps+2
+// linhas da frente cabem no L2. O resultado fica em u; tmp é um vetor do
+// mesmo tamanho (o contorno é copiado de u).
+void stencilJacobiSweeps(const StencilGrid &g, double *u, double *tmp, const double *f, double omega, int sweeps);
+
+// r = f - Δh u no interior; devolve ||r||²
+double stencilResidual(const StencilGrid &g, const double *u, const double *f, double *r);
+
+// operações de ponto flutuante por ponto de cada núcleo, para o benchmark
+const int STENCIL_JACOBI_FLOPS = 10;
+const int STENCIL_RESIDUAL_FLOPS = 10;
+
+#endif
@@ -0,0 +1,96 @@
+#include "stencil.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// Benchmark no estilo roofline dos núcleos de estêncil: para cada versão
+// (escalar, AVX2, AVX-512) e cada forma de percorrer a malha, mede GFLOP/s e
+// a banda efetiva em GB/s, contando o tráfego mínimo com a memória (cada
+// vetor lido ou escrito uma vez por passada; a escrita conta em dobro pela
+// leitura da linha de cache antes de escrever). O teto de banda é a tríade do
+// STREAM nos mesmos tamanhos, e o teto do núcleo é intensidade x banda.
+// uso: ./stencil_bench [N M] [repetições]
+
+namespace {
+
+double secondsSince(std::chrono::steady_clock::time_point t0) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// a[i] = b[i] + s c[i]; devolve GB/s (3 vetores + leitura para escrita)
+double streamTriad(size_t n, int reps) {
+	std::vector<double> a(n, 0.0), b(n, 1.0), c(n, 2.0);
+	double best = 1e30;
+	for (int r = 0; r < reps; ++r) {
+		auto t0 = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < n; ++i)
+			a[i] = b[i] + 3.0 * c[i];
+		best = std::min(best, secondsSince(t0));
+	}
+	volatile double sink = a[n / 2];
+	(void)sink;
+	return 4.0 * sizeof(double) * n / best / 1e9;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+	int N = argc > 2 ? atoi(argv[1]) : 4096;
+	int M = argc > 2 ? atoi(argv[2]) : 2048;
+	int reps = argc > 3 ? atoi(argv[3]) : 5;
+	const size_t size = size_t(N + 1) * (M + 1);
+	const double points = double(N - 1) * (M - 1);
+	StencilGrid g{N, M, N + 1, N * N / 4.0, double(M) * M};
+
+	std::vector<double> u(size, 0.0), tmp(size, 0.0), f(size, 1.0), r(size, 0.0);
+	for (size_t k = 0; k < size; ++k)
+		u[k] = double(k % 97) / 97.0;
+
+	double bandwidth = streamTriad(size, reps);
+	printf("malha %dx%d (%.1f MiB por vetor), tríade STREAM: %.1f GB/s\n", N, M, size * 8.0 / 1048576.0, bandwidth);
+	printf("%-8s %-12s %10s %9s %9s %11s %13s\n", "versão", "núcleo", "ms/varr.", "GFLOP/s", "GB/s", "flop/byte",
+	       "teto GFLOP/s");
+
+	struct Variant {
+		const char *name;
+		int flops;
+		double bytes; // por ponto e por varredura
+		int sweeps;
+	};
+	const int temporal = 4;
+	const Variant variants[] = {
+	    {"jacobi", STENCIL_JACOBI_FLOPS, 32.0, 1},
+	    {"jacobi-blk", STENCIL_JACOBI_FLOPS, 32.0, 1},
+	    {"jacobi-t4", STENCIL_JACOBI_FLOPS, 32.0 / temporal, temporal},
+	    {"residuo", STENCIL_RESIDUAL_FLOPS, 32.0, 1},
+	};
+
+	for (int isa = 0; isa <= int(stencilBestIsa()); ++isa) {
+		stencilSetIsa(StencilIsa(isa));
+		for (int v = 0; v < 4; ++v) {
+			const Variant &var = variants[v];
+			double best = 1e30;
+			for (int rep = 0; rep < reps; ++rep) {
+				auto t0 = std::chrono::steady_clock::now();
+				if (v == 0)
+					stencilJacobi(g, u.data(), f.data(), tmp.data(), 0.8);
+				else if (v == 1)
+					stencilJacobi(g, u.data(), f.data(), tmp.data(), 0.8, 512);
+				else if (v == 2)
+					stencilJacobiSweeps(g, u.data(), tmp.data(), f.data(), 0.8, temporal);
+				else
+					stencilResidual(g, u.data(), f.data(), r.data());
+				best = std::min(best, secondsSince(t0) / var.sweeps);
+			}
+			double gflops = points * var.flops / best / 1e9;
+			double gbytes = points * var.bytes / best / 1e9;
+			double intensity = var.flops / var.bytes;
+			printf("%-8s %-12s %10.2f %9.2f %9.1f %11.2f %13.2f\n", stencilIsaName(StencilIsa(isa)), var.name,
+			       best * 1e3, gflops, gbytes, intensity, intensity * bandwidth);
+			fflush(stdout);
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,83 @@
+#define STB_IMAGE_IMPLEMENTATION
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "stb_image.h"
+#include "stb_image_write.h"
+#include "png_encoder.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Mede a taxa de codificação (MB/s de pixels de entrada) e o tamanho da saída
+// de cada modo do codificador, conferindo a decodificação com o stb_image.
+// uso: ./bench_png [imagem pontilhada] [repeticoes]
+int main(int argc, char **argv) {
+	string input_file = argc > 1 ? argv[1] : "saida.png";
+	int reps = argc > 2 ? atoi(argv[2]) : 5;
+
+	int width, height, channels;
+	unsigned char *img = stbi_load(input_file.c_str(), &width, &height, &channels, 1);
+	if (!img) {
+		cerr << "Erro ao carregar a imagem.\n" << input_file << "\n";
+		return 1;
+	}
+	double raw_mb = double(width) * height / (1024.0 * 1024.0);
+	printf("%s: %d x %d (%.2f MB em tons de cinza)\n\n", input_file.c_str(), width, height, raw_mb);
+	printf("%-8s %5s %7s %7s %6s %10s %10s %7s\n", "modo", "nivel", "filtro", "threads", "bits", "MB/s", "bytes",
+	       "razao");
+
+	struct Config {
+		PngMode mode;
+		int level;
+		PngFilter filter;
+		int threads;
+		int bit_depth;
+	};
+	const Config configs[] = {
+	    {PngMode::Stb, 8, PngFilter::Adaptive, 1, 8},      {PngMode::Stored, 0, PngFilter::None, 1, 8},
+	    {PngMode::Stored, 0, PngFilter::None, 1, 0},       {PngMode::Rle, 0, PngFilter::None, 1, 8},
+	    {PngMode::Rle, 0, PngFilter::Adaptive, 1, 8},      {PngMode::Rle, 0, PngFilter::Adaptive, 1, 0},
+	    {PngMode::Deflate, 1, PngFilter::Adaptive, 1, 0},  {PngMode::Deflate, 6, PngFilter::None, 1, 8},
+	    {PngMode::Deflate, 6, PngFilter::Adaptive, 1, 8},  {PngMode::Deflate, 6, PngFilter::None, 1, 0},
+	    {PngMode::Deflate, 6, PngFilter::Adaptive, 1, 0},  {PngMode::Deflate, 9, PngFilter::Adaptive, 1, 0},
+	    {PngMode::Deflate, 6, PngFilter::Adaptive, 0, 0},  {PngMode::Deflate, 9, PngFilter::Adaptive, 0, 0},
+	};
+	const char *filter_names[] = {"none", "sub", "up", "avg", "paeth", "adapt"};
+
+	vector<unsigned char> out;
+	for (const Config &c : configs) {
+		PngOptions opt;
+		opt.mode = c.mode;
+		opt.level = c.level;
+		opt.filter = c.filter;
+		opt.threads = c.threads;
+		opt.bit_depth = c.bit_depth;
+
+		double best = 1e30;
+		for (int r = 0; r < reps; ++r) {
+			auto t0 = chrono::steady_clock::now();
+			png_encode(out, img, width, height, 1, width, opt);
+			auto t1 = chrono::steady_clock::now();
+			best = min(best, chrono::duration<double>(t1 - t0).count());
+		}
+
+		int w, h, n;
+		unsigned char *back = stbi_load_from_memory(out.data(), int(out.size()), &w, &h, &n, 1);
+		bool ok = back && w == width && h == height;
+		for (int i = 0; ok && i < width * height; ++i)
+			ok = (back[i] >= 128) == (img[i] >= 128) && (c.bit_depth == 0 || back[i] == img[i]);
+		stbi_image_free(back);
+
+		printf("%-8s %5d %7s %7d %6s %10.1f %10zu %6.1f%%%s\n", png_mode_name(c.mode), c.level,
+		       filter_names[int(c.filter)], c.threads, c.bit_depth == 0 ? "auto" : c.bit_depth == 1 ? "1" : "8",
+		       raw_mb / best, out.size(), 100.0 * out.size() / (double(width) * height), ok ? "" : "  ERRO");
+	}
+
+	stbi_image_free(img);
+	return 0;
+}
@@ -2,9 +2,14 @@
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include "stb_image.h"
 #include "stb_image_write.h"
+#include "jpeg_stream.h"
+#include "png_encoder.h"
 #include <algorithm>
+#include <cstdio>
+#include <cstdlib>
 #include <iostream>
 #include <string>
+#include <vector>
 
 using namespace std;
 
@@ -12,36 +17,150 @@ int clamp(int value, int min_val, int max_val) {
     return max(min_val, min(value, max_val));
 }
 
-void dithering(unsigned char *img, int width, int height) {
-	for (int y = 0; y < height; ++y) {
-		for (int x = 0; x < width; ++x) {
-			int i = y * width + x;
-			int old = img[i];
-			int new_pixel;
-			if (old < 128) {
-				new_pixel = 0;
-			} else {
-				new_pixel = 255;
+// quantiza a linha `cur` e difunde o erro nela mesma e em `next` (nullptr na
+// última linha); o erro é acumulado direto nos pixels, com saturação
+void dither_row(unsigned char *cur, unsigned char *next, int width) {
+	for (int x = 0; x < width; ++x) {
+		int old = cur[x];
+		int new_pixel;
+		if (old < 128) {
+			new_pixel = 0;
+		} else {
+			new_pixel = 255;
+		}
+		cur[x] = new_pixel;
+		int erro = old - new_pixel;
+		if (x + 1 < width) {
+			cur[x + 1] = clamp(cur[x + 1] + erro * 7 / 16, 0, 255);
+		}
+		if (next) {
+			if (x > 0) {
+				next[x - 1] = clamp(next[x - 1] + erro * 3 / 16, 0, 255);
 			}
-			int erro = old - new_pixel;
+			next[x] = clamp(next[x] + erro * 5 / 16, 0, 255);
 			if (x + 1 < width) {
-				img[i + 1] = clamp(img[i + 1] + erro * 7 / 16, 0, 255);
-			}
-			if (y + 1 < height) {
-				if (x > 0) {
-					img[i + width - 1] = clamp(img[i + width - 1] + erro * 3 / 16, 0, 255);
-					img[i + width] = clamp(img[i + width] + erro * 5 / 16, 0, 255);
-					if (x + 1 < width) {
-						img[i + width + 1] = clamp(img[i + width + 1] + erro * 1 / 16, 0, 255);
-					}
-				}
+				next[x + 1] = clamp(next[x + 1] + erro * 1 / 16, 0, 255);
 			}
 		}
 	}
 }
-int main() {
-	string input_file = "cell.jpg";
-	string output_file = "cell_gray.png";
+
+void dithering(unsigned char *img, int width, int height) {
+	for (int y = 0; y < height; ++y) {
+		unsigned char *next = y + 1 < height ? img + (y + 1) * width : nullptr;
+		dither_row(img + y * width, next, width);
+	}
+}
+
+bool ends_with(const string &s, const string &suffix) {
+	return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// grava linhas já pontilhadas assim que ficam prontas, em PBM (P4) ou PNG de 1 bit
+struct RowWriter {
+	PngStreamWriter png;
+	FILE *pbm = nullptr;
+	vector<unsigned char> packed;
+	int width = 0;
+
+	bool open(const string &filename, int w, int h, PngOptions opt) {
+		width = w;
+		if (!ends_with(filename, ".pbm")) {
+			if (opt.bit_depth == 0)
+				opt.bit_depth = 1;
+			return png.open(filename.c_str(), w, h, 1, opt);
+		}
+		pbm = fopen(filename.c_str(), "wb");
+		if (!pbm)
+			return false;
+		packed.resize((w + 7) / 8);
+		return fprintf(pbm, "P4\n%d %d\n", w, h) > 0;
+	}
+
+	bool write(const unsigned char *row) {
+		if (!pbm)
+			return png.write_rows(row, 1, width);
+		fill(packed.begin(), packed.end(), 0);
+		for (int x = 0; x < width; ++x)
+			if (row[x] < 128) // no PBM, 1 é preto
+				packed[x >> 3] |= 0x80 >> (x & 7);
+		return fwrite(packed.data(), 1, packed.size(), pbm) == packed.size();
+	}
+
+	bool close() {
+		if (!pbm)
+			return png.close();
+		bool ok = fclose(pbm) == 0;
+		pbm = nullptr;
+		return ok;
+	}
+};
+
+// Decodifica o JPEG por faixas de MCU e pontilha em fluxo: além da faixa do
+// decodificador, só a linha atual e a seguinte (que recebe o erro) ficam em memória.
+bool dither_stream(JpegStreamDecoder &dec, const string &output_file, const PngOptions &png) {
+	int width = dec.width(), height = dec.height();
+	vector<unsigned char> cur(width), next(width);
+	RowWriter writer;
+	if (!writer.open(output_file, width, height, png))
+		return false;
+	if (!dec.read_row(cur.data())) {
+		cerr << "Erro ao decodificar o JPEG: " << dec.error() << "\n";
+		return false;
+	}
+	for (int y = 0; y < height; ++y) {
+		bool has_next = y + 1 < height;
+		if (has_next && !dec.read_row(next.data())) {
+			cerr << "Erro ao decodificar o JPEG: " << dec.error() << "\n";
+			return false;
+		}
+		dither_row(cur.data(), has_next ? next.data() : nullptr, width);
+		if (!writer.write(cur.data()))
+			return false;
+		swap(cur, next);
+	}
+	return writer.close();
+}
+
+bool save_image(const string &output_file, const unsigned char *img, int width, int height, const PngOptions &png) {
+	if (!ends_with(output_file, ".pbm"))
+		return png_write(output_file.c_str(), img, width, height, 1, width, png);
+	RowWriter writer;
+	if (!writer.open(output_file, width, height, png))
+		return false;
+	for (int y = 0; y < height; ++y)
+		if (!writer.write(img + y * width))
+			return false;
+	return writer.close();
+}
+
+// uso: ./main [entrada] [saida .png|.pbm] [stb|stored|rle|deflate] [nivel] [threads]
+int main(int argc, char **argv) {
+	string input_file = argc > 1 ? argv[1] : "cell.jpg";
+	string output_file = argc > 2 ? argv[2] : "cell_gray.png";
+
+	PngOptions png;
+	if (argc > 3 && !png_mode_from_string(argv[3], png.mode)) {
+		cerr << "Modo de PNG desconhecido: " << argv[3] << "\n";
+		return 1;
+	}
+	if (argc > 4)
+		png.level = atoi(argv[4]);
+	if (argc > 5)
+		png.threads = atoi(argv[5]);
+
+	// JPEG baseline: decodificação e pontilhamento em fluxo, com memória limitada
+	JpegStreamDecoder dec;
+	if (dec.open(input_file.c_str())) {
+		cout << "Imagem em fluxo: " << input_file << "(" << dec.width() << " x " << dec.height() << ")\n";
+		if (!dither_stream(dec, output_file, png)) {
+			cerr << "Erro ao salvar a imagem.\n" << output_file << "\n";
+			return 2;
+		}
+		cout << "Dithering concluído com sucesso.\n";
+		cout << "Imagem salva como: " << output_file << "\n";
+		return 0;
+	}
 
 	int width, height, channels;
 	unsigned char *img = stbi_load(input_file.c_str(), &width, &height, &channels, 1);
@@ -53,12 +172,12 @@ int main() {
 	cout << "Imagem carregada: " << input_file << "(" << width << " x " << height << ")\n";
 
 	dithering(img, width, height);
-	if (!stbi_write_png(output_file.c_str(), width, height, 1, img, width)) {
+	if (!save_image(output_file, img, width, height, png)) {
 		cerr << "Erro ao salvar a imagem.\n" << output_file << "\n";
 		stbi_image_free(img);
 		return 2;
 	}
-	cout << "Dithering concluÃ­do com sucesso.\n";
+	cout << "Dithering concluído com sucesso.\n";
 	cout << "Imagem salva como: " << output_file << "\n";
 
 	stbi_image_free(img);
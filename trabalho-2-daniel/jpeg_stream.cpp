@@ -0,0 +1,507 @@
+#include "jpeg_stream.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+namespace {
+
+const size_t READ_CHUNK = 1 << 16;
+
+// posição natural de cada coeficiente na ordem zigue-zague (+15 de folga para k estourar)
+const unsigned char dezigzag[64 + 15] = {
+    0,  1,  8,  16, 9,  2,  3,  10, 17, 24, 32, 25, 18, 11, 4,  5,  12, 19, 26, 33, 40, 48, 41, 34, 27, 20,
+    13, 6,  7,  14, 21, 28, 35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51, 58, 59, 52, 45,
+    38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63};
+
+inline unsigned char clamp_byte(int x) {
+	return (unsigned)x > 255 ? (x < 0 ? 0 : 255) : (unsigned char)x;
+}
+
+inline int f2f(float x) {
+	return int(x * 4096 + 0.5f);
+}
+
+// IDCT 1D inteira do stb_image (derivada do jidctint do IJG); mesma aritmética
+// para que a saída seja idêntica à do stbi_load
+struct Idct1D {
+	int t0, t1, t2, t3, x0, x1, x2, x3;
+	Idct1D(int s0, int s1, int s2, int s3, int s4, int s5, int s6, int s7) {
+		int p1, p2, p3, p4, p5;
+		p2 = s2;
+		p3 = s6;
+		p1 = (p2 + p3) * f2f(0.5411961f);
+		t2 = p1 + p3 * f2f(-1.847759065f);
+		t3 = p1 + p2 * f2f(0.765366865f);
+		p2 = s0;
+		p3 = s4;
+		t0 = (p2 + p3) * 4096;
+		t1 = (p2 - p3) * 4096;
+		x0 = t0 + t3;
+		x3 = t0 - t3;
+		x1 = t1 + t2;
+		x2 = t1 - t2;
+		t0 = s7;
+		t1 = s5;
+		t2 = s3;
+		t3 = s1;
+		p3 = t0 + t2;
+		p4 = t1 + t3;
+		p1 = t0 + t3;
+		p2 = t1 + t2;
+		p5 = (p3 + p4) * f2f(1.175875602f);
+		t0 = t0 * f2f(0.298631336f);
+		t1 = t1 * f2f(2.053119869f);
+		t2 = t2 * f2f(3.072711026f);
+		t3 = t3 * f2f(1.501321110f);
+		p1 = p5 + p1 * f2f(-0.899976223f);
+		p2 = p5 + p2 * f2f(-2.562915447f);
+		p3 = p3 * f2f(-1.961570560f);
+		p4 = p4 * f2f(-0.390180644f);
+		t3 += p1 + p4;
+		t2 += p2 + p3;
+		t1 += p2 + p4;
+		t0 += p1 + p3;
+	}
+};
+
+void idct_block(unsigned char *out, int stride, const short data[64]) {
+	int val[64];
+	for (int i = 0; i < 8; ++i) {
+		const short *d = data + i;
+		int *v = val + i;
+		if (d[8] == 0 && d[16] == 0 && d[24] == 0 && d[32] == 0 && d[40] == 0 && d[48] == 0 && d[56] == 0) {
+			int dc = d[0] * 4;
+			v[0] = v[8] = v[16] = v[24] = v[32] = v[40] = v[48] = v[56] = dc;
+			continue;
+		}
+		Idct1D c(d[0], d[8], d[16], d[24], d[32], d[40], d[48], d[56]);
+		c.x0 += 512;
+		c.x1 += 512;
+		c.x2 += 512;
+		c.x3 += 512;
+		v[0] = (c.x0 + c.t3) >> 10;
+		v[56] = (c.x0 - c.t3) >> 10;
+		v[8] = (c.x1 + c.t2) >> 10;
+		v[48] = (c.x1 - c.t2) >> 10;
+		v[16] = (c.x2 + c.t1) >> 10;
+		v[40] = (c.x2 - c.t1) >> 10;
+		v[24] = (c.x3 + c.t0) >> 10;
+		v[32] = (c.x3 - c.t0) >> 10;
+	}
+	for (int i = 0; i < 8; ++i, out += stride) {
+		const int *v = val + 8 * i;
+		Idct1D r(v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7]);
+		const int bias = 65536 + (128 << 17);
+		r.x0 += bias;
+		r.x1 += bias;
+		r.x2 += bias;
+		r.x3 += bias;
+		out[0] = clamp_byte((r.x0 + r.t3) >> 17);
+		out[7] = clamp_byte((r.x0 - r.t3) >> 17);
+		out[1] = clamp_byte((r.x1 + r.t2) >> 17);
+		out[6] = clamp_byte((r.x1 - r.t2) >> 17);
+		out[2] = clamp_byte((r.x2 + r.t1) >> 17);
+		out[5] = clamp_byte((r.x2 - r.t1) >> 17);
+		out[3] = clamp_byte((r.x3 + r.t0) >> 17);
+		out[4] = clamp_byte((r.x3 - r.t0) >> 17);
+	}
+}
+
+} // namespace
+
+JpegStreamDecoder::~JpegStreamDecoder() {
+	if (file)
+		fclose(file);
+}
+
+bool JpegStreamDecoder::fail(const char *msg, bool unsup) {
+	err = msg;
+	not_supported = unsup;
+	return false;
+}
+
+int JpegStreamDecoder::get_byte() {
+	if (in_pos == in_len) {
+		in_len = fread(in_buf.data(), 1, in_buf.size(), file);
+		in_pos = 0;
+		if (in_len == 0)
+			return -1;
+	}
+	return in_buf[in_pos++];
+}
+
+int JpegStreamDecoder::get_u16() {
+	int hi = get_byte(), lo = get_byte();
+	if (hi < 0 || lo < 0)
+		return -1;
+	return (hi << 8) | lo;
+}
+
+bool JpegStreamDecoder::open(const char *filename) {
+	file = fopen(filename, "rb");
+	if (!file)
+		return fail("não foi possível abrir o arquivo");
+	in_buf.resize(READ_CHUNK);
+	if (!read_headers())
+		return false;
+
+	band.assign(size_t(band_w) * band_h, 0);
+	band_first = 0;
+	band_rows = 0;
+	rows_out = 0;
+	mcu_row = 0;
+	todo = restart_interval;
+	code_buffer = 0;
+	code_bits = 0;
+	marker = -1;
+	for (auto &c : comps)
+		c.dc_pred = 0;
+	return true;
+}
+
+bool JpegStreamDecoder::build_huffman(Huffman &hf, const int *counts) {
+	int k = 0;
+	for (int i = 0; i < 16; ++i)
+		for (int j = 0; j < counts[i]; ++j)
+			hf.size[k++] = (unsigned char)(i + 1);
+	hf.size[k] = 0;
+
+	unsigned code = 0;
+	k = 0;
+	for (int j = 1; j <= 16; ++j) {
+		hf.delta[j] = k - int(code);
+		if (hf.size[k] == j) {
+			while (hf.size[k] == j)
+				hf.code[k++] = (unsigned short)(code++);
+			if (code - 1 >= (1u << j))
+				return fail("tabela de Huffman inválida");
+		}
+		hf.maxcode[j] = code << (16 - j);
+		code <<= 1;
+	}
+	hf.maxcode[17] = 0xffffffffu;
+
+	memset(hf.fast, 255, sizeof(hf.fast));
+	for (int i = 0; i < k; ++i) {
+		int s = hf.size[i];
+		if (s <= 9) {
+			int c = hf.code[i] << (9 - s), m = 1 << (9 - s);
+			for (int j = 0; j < m; ++j)
+				hf.fast[c + j] = (unsigned char)i;
+		}
+	}
+	return true;
+}
+
+bool JpegStreamDecoder::read_headers() {
+	if (get_byte() != 0xff || get_byte() != 0xd8)
+		return fail("não é um arquivo JPEG");
+
+	bool have_frame = false;
+	for (;;) {
+		int m = get_byte();
+		while (m >= 0 && m != 0xff)
+			m = get_byte();
+		while (m == 0xff)
+			m = get_byte();
+		if (m < 0)
+			return fail("fim de arquivo inesperado");
+
+		if (m == 0xd8 || (m >= 0xd0 && m <= 0xd7) || m == 0x01)
+			continue; // marcadores sem segmento
+		if (m == 0xd9)
+			return fail("JPEG sem imagem");
+
+		int len = get_u16();
+		if (len < 2)
+			return fail("segmento inválido");
+		len -= 2;
+
+		if (m == 0xc0 || m == 0xc1) {
+			int precision = get_byte();
+			img_h = get_u16();
+			img_w = get_u16();
+			int nf = get_byte();
+			if (precision != 8)
+				return fail("JPEG de 12 bits não suportado", true);
+			if (img_h <= 0 || img_w <= 0)
+				return fail("dimensões inválidas", true);
+			if (nf != 1 && nf != 3)
+				return fail("número de componentes não suportado", true);
+			comps.resize(nf);
+			hmax = vmax = 1;
+			for (auto &c : comps) {
+				c.id = get_byte();
+				int hv = get_byte();
+				c.tq = get_byte();
+				c.h = hv >> 4;
+				c.v = hv & 15;
+				if (c.h < 1 || c.h > 4 || c.v < 1 || c.v > 4 || c.tq < 0 || c.tq > 3)
+					return fail("componente inválido");
+				hmax = max(hmax, c.h);
+				vmax = max(vmax, c.v);
+			}
+			if (len != 6 + 3 * nf)
+				return fail("SOF inválido");
+			len = 0;
+			have_frame = true;
+		} else if (m >= 0xc2 && m <= 0xcf && m != 0xc4 && m != 0xc8 && m != 0xcc) {
+			return fail("JPEG progressivo/aritmético não suportado", true);
+		} else if (m == 0xc4) {
+			while (len > 0) {
+				int tcth = get_byte(), tc = tcth >> 4, th = tcth & 15;
+				if (tc > 1 || th > 3)
+					return fail("DHT inválido");
+				int counts[16], total = 0;
+				for (int i = 0; i < 16; ++i) {
+					counts[i] = get_byte();
+					total += counts[i];
+				}
+				if (total > 256)
+					return fail("DHT inválido");
+				Huffman &hf = tc == 0 ? huff_dc[th] : huff_ac[th];
+				if (!build_huffman(hf, counts))
+					return false;
+				for (int i = 0; i < total; ++i)
+					hf.values[i] = (unsigned char)get_byte();
+				len -= 17 + total;
+			}
+		} else if (m == 0xdb) {
+			while (len > 0) {
+				int pqtq = get_byte(), pq = pqtq >> 4, tq = pqtq & 15;
+				if (pq > 1 || tq > 3)
+					return fail("DQT inválido");
+				for (int i = 0; i < 64; ++i)
+					dequant[tq][dezigzag[i]] = (unsigned short)(pq ? get_u16() : get_byte());
+				len -= 65 + (pq ? 64 : 0);
+			}
+		} else if (m == 0xdd) {
+			restart_interval = get_u16();
+			len -= 2;
+		} else if (m == 0xe0 || m == 0xee) {
+			// JFIF/Adobe decidem se 3 componentes são YCbCr ou RGB
+			unsigned char tag[12] = {0};
+			int n = min(len, 12);
+			for (int i = 0; i < n; ++i)
+				tag[i] = (unsigned char)get_byte();
+			len -= n;
+			if (m == 0xe0 && n >= 5 && memcmp(tag, "JFIF", 5) == 0)
+				jfif = 1;
+			if (m == 0xee && n >= 12 && memcmp(tag, "Adobe", 5) == 0)
+				app14_transform = tag[11];
+			for (; len > 0; --len)
+				get_byte();
+		} else if (m == 0xda) {
+			if (!have_frame)
+				return fail("SOS antes do SOF");
+			int ns = get_byte();
+			if (ns < 1 || ns > int(comps.size()))
+				return fail("SOS inválido");
+			scan_comps.clear();
+			for (int i = 0; i < ns; ++i) {
+				int id = get_byte(), tbl = get_byte();
+				int k = 0;
+				while (k < int(comps.size()) && comps[k].id != id)
+					++k;
+				if (k == int(comps.size()))
+					return fail("componente desconhecido no SOS");
+				comps[k].hd = tbl >> 4;
+				comps[k].ha = tbl & 15;
+				if (comps[k].hd > 3 || comps[k].ha > 3)
+					return fail("SOS inválido");
+				scan_comps.push_back(k);
+			}
+			int ss = get_byte(), se = get_byte();
+			get_byte();
+			if (ss != 0 || se != 63)
+				return fail("SOS inválido");
+
+			if (comps.size() == 3) {
+				bool rgb = comps[0].id == 'R' && comps[1].id == 'G' && comps[2].id == 'B';
+				if (rgb || (app14_transform == 0 && !jfif))
+					return fail("JPEG RGB não suportado", true);
+			}
+			// a luminância precisa vir no primeiro scan e com a amostragem máxima
+			if (find(scan_comps.begin(), scan_comps.end(), 0) == scan_comps.end() || comps[0].h != hmax ||
+			    comps[0].v != vmax)
+				return fail("organização de scans não suportada", true);
+
+			if (ns > 1) {
+				mcus_x = (img_w + 8 * hmax - 1) / (8 * hmax);
+				mcus_y = (img_h + 8 * vmax - 1) / (8 * vmax);
+				band_w = mcus_x * 8 * hmax;
+				band_h = 8 * vmax;
+			} else {
+				mcus_x = (img_w + 7) / 8;
+				mcus_y = (img_h + 7) / 8;
+				band_w = mcus_x * 8;
+				band_h = 8;
+			}
+			return true;
+		} else {
+			for (; len > 0; --len)
+				if (get_byte() < 0)
+					return fail("fim de arquivo inesperado");
+		}
+		if (len != 0)
+			return fail("tamanho de segmento inválido");
+	}
+}
+
+void JpegStreamDecoder::fill_bits() {
+	do {
+		int b = 0;
+		if (marker < 0) {
+			b = get_byte();
+			if (b < 0) {
+				marker = 0xd9;
+				b = 0;
+			} else if (b == 0xff) {
+				int c = get_byte();
+				while (c == 0xff)
+					c = get_byte();
+				if (c != 0) {
+					marker = c < 0 ? 0xd9 : c;
+					b = 0;
+				}
+			}
+		}
+		code_buffer |= unsigned(b) << (24 - code_bits);
+		code_bits += 8;
+	} while (code_bits <= 24);
+}
+
+int JpegStreamDecoder::huff_decode(const Huffman &hf) {
+	if (code_bits < 16)
+		fill_bits();
+	int k = hf.fast[code_buffer >> (32 - 9)];
+	if (k < 255) {
+		int s = hf.size[k];
+		code_buffer <<= s;
+		code_bits -= s;
+		return hf.values[k];
+	}
+	unsigned temp = code_buffer >> 16;
+	for (k = 10; temp >= hf.maxcode[k]; ++k)
+		;
+	if (k == 17 || k > code_bits)
+		return -1;
+	int c = int((code_buffer >> (32 - k)) & ((1u << k) - 1)) + hf.delta[k];
+	if (c < 0 || c > 255)
+		return -1;
+	code_buffer <<= k;
+	code_bits -= k;
+	return hf.values[c];
+}
+
+int JpegStreamDecoder::extend_receive(int n) {
+	if (n == 0)
+		return 0;
+	if (code_bits < n)
+		fill_bits();
+	int k = int(code_buffer >> (32 - n));
+	code_buffer <<= n;
+	code_bits -= n;
+	return k < (1 << (n - 1)) ? k - (1 << n) + 1 : k;
+}
+
+bool JpegStreamDecoder::decode_block(short data[64], Component &c, bool keep) {
+	int t = huff_decode(huff_dc[c.hd]);
+	if (t < 0 || t > 15)
+		return fail("código de Huffman inválido");
+	c.dc_pred += extend_receive(t);
+	const unsigned short *dq = dequant[c.tq];
+	if (keep) {
+		memset(data, 0, 64 * sizeof(short));
+		data[0] = (short)(c.dc_pred * dq[0]);
+	}
+
+	for (int k = 1; k < 64;) {
+		int rs = huff_decode(huff_ac[c.ha]);
+		if (rs < 0)
+			return fail("código de Huffman inválido");
+		int s = rs & 15, r = rs >> 4;
+		if (s == 0) {
+			if (rs != 0xf0)
+				break; // fim do bloco
+			k += 16;
+			continue;
+		}
+		k += r;
+		int v = extend_receive(s);
+		if (keep) {
+			int zig = dezigzag[k];
+			data[zig] = (short)(v * dq[zig]);
+		}
+		++k;
+	}
+	return true;
+}
+
+bool JpegStreamDecoder::handle_restart() {
+	code_buffer = 0;
+	code_bits = 0;
+	if (marker < 0) {
+		// procura o próximo marcador RSTn
+		int b = get_byte();
+		for (;;) {
+			while (b >= 0 && b != 0xff)
+				b = get_byte();
+			while (b == 0xff)
+				b = get_byte();
+			if (b != 0)
+				break;
+			b = get_byte();
+		}
+		marker = b;
+	}
+	if (marker < 0xd0 || marker > 0xd7)
+		return fail("marcador de reinício ausente");
+	marker = -1;
+	todo = restart_interval;
+	for (auto &c : comps)
+		c.dc_pred = 0;
+	return true;
+}
+
+bool JpegStreamDecoder::decode_mcu_row() {
+	if (mcu_row >= mcus_y)
+		return fail("dados da imagem acabaram");
+	short data[64];
+	bool interleaved = scan_comps.size() > 1;
+	for (int mx = 0; mx < mcus_x; ++mx) {
+		for (int k : scan_comps) {
+			Component &c = comps[k];
+			int bh = interleaved ? c.h : 1, bv = interleaved ? c.v : 1;
+			for (int by = 0; by < bv; ++by) {
+				for (int bx = 0; bx < bh; ++bx) {
+					bool keep = k == 0;
+					if (!decode_block(data, c, keep))
+						return false;
+					if (keep)
+						idct_block(&band[size_t(by) * 8 * band_w + (mx * bh + bx) * 8], band_w, data);
+				}
+			}
+		}
+		bool last = mcu_row == mcus_y - 1 && mx == mcus_x - 1;
+		if (restart_interval && --todo == 0 && !last && !handle_restart())
+			return false;
+	}
+	++mcu_row;
+	return true;
+}
+
+bool JpegStreamDecoder::read_row(unsigned char *row) {
+	if (!file || rows_out >= img_h)
+		return false;
+	if (rows_out >= band_first + band_rows) {
+		band_first += band_rows;
+		if (!decode_mcu_row())
+			return false;
+		band_rows = min(band_h, img_h - band_first);
+	}
+	memcpy(row, &band[size_t(rows_out - band_first) * band_w], img_w);
+	++rows_out;
+	return true;
+}
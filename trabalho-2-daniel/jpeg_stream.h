@@ -0,0 +1,85 @@
+#ifndef JPEG_STREAM_H
+#define JPEG_STREAM_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Decodificador JPEG baseline que entrega a luminância uma linha por vez.
+//
+// Só uma faixa de MCUs (8 ou 16 linhas de Y) fica em memória, e os blocos de
+// crominância são lidos do fluxo mas descartados. A IDCT é a mesma do
+// stb_image, então as linhas são idênticas às de stbi_load(..., 1).
+// JPEG progressivo, aritmético, CMYK ou RGB sem transformação YCbCr não são
+// suportados: open() falha com unsupported() verdadeiro e quem chama deve
+// cair para o stbi_load.
+class JpegStreamDecoder {
+public:
+	JpegStreamDecoder() = default;
+	~JpegStreamDecoder();
+	JpegStreamDecoder(const JpegStreamDecoder &) = delete;
+	JpegStreamDecoder &operator=(const JpegStreamDecoder &) = delete;
+
+	bool open(const char *filename);
+	// copia a próxima linha (width bytes) para `row`
+	bool read_row(unsigned char *row);
+
+	int width() const { return img_w; }
+	int height() const { return img_h; }
+	bool unsupported() const { return not_supported; }
+	const std::string &error() const { return err; }
+
+private:
+	struct Huffman {
+		unsigned char fast[1 << 9]; // índice do símbolo para os 9 primeiros bits, 255 = código mais longo
+		unsigned char values[256];
+		unsigned char size[257];
+		unsigned short code[256];
+		unsigned maxcode[18];
+		int delta[17];
+	};
+	struct Component {
+		int id, h, v, tq;
+		int hd, ha; // tabelas de Huffman DC/AC
+		int dc_pred;
+	};
+
+	bool fail(const char *msg, bool unsup = false);
+	int get_byte();
+	int get_u16();
+	bool read_headers();
+	bool build_huffman(Huffman &hf, const int *counts);
+	void fill_bits();
+	int huff_decode(const Huffman &hf);
+	int extend_receive(int n);
+	bool decode_block(short data[64], Component &c, bool keep);
+	bool handle_restart();
+	bool decode_mcu_row();
+
+	std::FILE *file = nullptr;
+	std::vector<unsigned char> in_buf; // leitura do arquivo em pedaços
+	size_t in_pos = 0, in_len = 0;
+
+	int img_w = 0, img_h = 0;
+	int hmax = 1, vmax = 1;
+	std::vector<Component> comps;
+	std::vector<int> scan_comps; // índices dos componentes do scan
+	unsigned short dequant[4][64];
+	Huffman huff_dc[4], huff_ac[4];
+	int restart_interval = 0, todo = 0;
+	int jfif = 0, app14_transform = -1;
+
+	unsigned code_buffer = 0;
+	int code_bits = 0;
+	int marker = -1; // marcador encontrado dentro dos dados entrópicos
+
+	int mcus_x = 0, mcus_y = 0, mcu_row = 0;
+	int band_w = 0, band_h = 0; // faixa de Y decodificada
+	std::vector<unsigned char> band;
+	int band_first = 0, band_rows = 0, rows_out = 0;
+
+	bool not_supported = false;
+	std::string err;
+};
+
+#endif
@@ -0,0 +1,892 @@
+#include "png_encoder.h"
+#include "stb_image_write.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <queue>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+namespace {
+
+// ---------------------------------------------------------------------------
+// Checksums
+
+uint32_t crc_table[256];
+
+struct CrcInit {
+	CrcInit() {
+		for (uint32_t n = 0; n < 256; ++n) {
+			uint32_t c = n;
+			for (int k = 0; k < 8; ++k)
+				c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+			crc_table[n] = c;
+		}
+	}
+} crc_init;
+
+uint32_t crc32(uint32_t crc, const unsigned char *p, size_t n) {
+	crc = ~crc;
+	for (size_t i = 0; i < n; ++i)
+		crc = crc_table[(crc ^ p[i]) & 0xff] ^ (crc >> 8);
+	return ~crc;
+}
+
+const uint32_t ADLER_BASE = 65521;
+
+uint32_t adler32(uint32_t adler, const unsigned char *p, size_t n) {
+	uint32_t a = adler & 0xffff, b = adler >> 16;
+	while (n > 0) {
+		size_t chunk = min(n, size_t(5552));
+		n -= chunk;
+		for (size_t i = 0; i < chunk; ++i) {
+			a += p[i];
+			b += a;
+		}
+		p += chunk;
+		a %= ADLER_BASE;
+		b %= ADLER_BASE;
+	}
+	return a | (b << 16);
+}
+
+// adler32 da concatenação de dois trechos, dado o tamanho do segundo (mesma fórmula do zlib)
+uint32_t adler32_combine(uint32_t a1, uint32_t a2, size_t len2) {
+	uint32_t rem = uint32_t(len2 % ADLER_BASE);
+	uint32_t sum1 = a1 & 0xffff;
+	uint32_t sum2 = uint32_t((uint64_t(rem) * sum1) % ADLER_BASE);
+	sum1 += (a2 & 0xffff) + ADLER_BASE - 1;
+	sum2 += (a1 >> 16) + (a2 >> 16) + ADLER_BASE - rem;
+	if (sum1 >= ADLER_BASE)
+		sum1 -= ADLER_BASE;
+	if (sum1 >= ADLER_BASE)
+		sum1 -= ADLER_BASE;
+	if (sum2 >= 2 * ADLER_BASE)
+		sum2 -= 2 * ADLER_BASE;
+	if (sum2 >= ADLER_BASE)
+		sum2 -= ADLER_BASE;
+	return sum1 | (sum2 << 16);
+}
+
+// ---------------------------------------------------------------------------
+// Deflate (RFC 1951)
+
+const unsigned short len_base[29] = {3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+                                     31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+const unsigned char len_extra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+const unsigned short dist_base[30] = {1,   2,   3,   4,   5,   7,    9,    13,   17,   25,   33,   49,   65,    97,    129,
+                                      193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+const unsigned char dist_extra[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+const unsigned char clen_order[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+const int WINDOW = 32768;
+const int MAX_MATCH = 258;
+const int HASH_BITS = 15;
+const size_t TOKENS_PER_BLOCK = 1 << 15;
+
+// tabelas comprimento -> código e distância -> código
+unsigned char len_code[MAX_MATCH + 1];
+unsigned char dist_code[512];
+// comprimentos do Huffman fixo
+unsigned char fixed_llen[288], fixed_dlen[30];
+
+struct CodeTablesInit {
+	CodeTablesInit() {
+		for (int c = 0; c < 29; ++c) {
+			int last = (c == 28) ? MAX_MATCH : len_base[c + 1] - 1;
+			for (int l = len_base[c]; l <= last && l <= MAX_MATCH; ++l)
+				len_code[l] = c;
+		}
+		len_code[MAX_MATCH] = 28;
+		for (int c = 0; c < 30; ++c) {
+			int first = dist_base[c], last = first + (1 << dist_extra[c]) - 1;
+			for (int d = first; d <= last; ++d) {
+				if (d <= 256)
+					dist_code[d - 1] = c;
+				else
+					dist_code[256 + ((d - 1) >> 7)] = c;
+			}
+		}
+		for (int i = 0; i < 288; ++i)
+			fixed_llen[i] = i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8;
+		for (int i = 0; i < 30; ++i)
+			fixed_dlen[i] = 5;
+	}
+} code_tables_init;
+
+inline int distance_code(int d) {
+	return d <= 256 ? dist_code[d - 1] : dist_code[256 + ((d - 1) >> 7)];
+}
+
+struct Token {
+	unsigned short len; // literal quando dist == 0
+	unsigned short dist;
+};
+
+struct BitWriter {
+	vector<unsigned char> &out;
+	uint64_t buf = 0;
+	int count = 0;
+
+	explicit BitWriter(vector<unsigned char> &o) : out(o) {}
+
+	void put(uint32_t bits, int n) {
+		buf |= uint64_t(bits) << count;
+		count += n;
+		while (count >= 8) {
+			out.push_back(buf & 0xff);
+			buf >>= 8;
+			count -= 8;
+		}
+	}
+	void align() {
+		if (count > 0)
+			out.push_back(buf & 0xff);
+		buf = 0;
+		count = 0;
+	}
+};
+
+unsigned reverse_bits(unsigned code, int len) {
+	unsigned r = 0;
+	for (int i = 0; i < len; ++i) {
+		r = (r << 1) | (code & 1);
+		code >>= 1;
+	}
+	return r;
+}
+
+// comprimentos de Huffman limitados a `limit` bits; se a árvore passar do
+// limite, as frequências são achatadas e a árvore é refeita
+void build_lengths(const unsigned *freq, int n, int limit, unsigned char *lens) {
+	vector<unsigned> f(freq, freq + n);
+	for (;;) {
+		struct Node {
+			unsigned weight;
+			int parent;
+		};
+		vector<Node> nodes;
+		vector<int> leaf(n, -1);
+		typedef pair<unsigned, int> Item;
+		priority_queue<Item, vector<Item>, greater<Item>> heap;
+		for (int i = 0; i < n; ++i) {
+			if (f[i] == 0)
+				continue;
+			leaf[i] = int(nodes.size());
+			heap.push({f[i], int(nodes.size())});
+			nodes.push_back({f[i], -1});
+		}
+		while (heap.size() > 1) {
+			Item a = heap.top();
+			heap.pop();
+			Item b = heap.top();
+			heap.pop();
+			int id = int(nodes.size());
+			nodes.push_back({a.first + b.first, -1});
+			nodes[a.second].parent = id;
+			nodes[b.second].parent = id;
+			heap.push({a.first + b.first, id});
+		}
+		// nós são criados depois dos filhos: percorrer de trás pra frente dá a profundidade
+		vector<int> depth(nodes.size(), 0);
+		for (int i = int(nodes.size()) - 2; i >= 0; --i)
+			depth[i] = depth[nodes[i].parent] + 1;
+
+		int maxlen = 0;
+		for (int i = 0; i < n; ++i) {
+			lens[i] = leaf[i] < 0 ? 0 : (unsigned char)max(1, depth[leaf[i]]);
+			maxlen = max(maxlen, int(lens[i]));
+		}
+		if (maxlen <= limit)
+			return;
+		for (auto &w : f)
+			if (w)
+				w = (w >> 1) | 1;
+	}
+}
+
+void build_codes(const unsigned char *lens, int n, unsigned short *codes) {
+	int bl_count[16] = {0}, next_code[16] = {0};
+	for (int i = 0; i < n; ++i)
+		bl_count[lens[i]]++;
+	bl_count[0] = 0;
+	int code = 0;
+	for (int bits = 1; bits < 16; ++bits) {
+		code = (code + bl_count[bits - 1]) << 1;
+		next_code[bits] = code;
+	}
+	for (int i = 0; i < n; ++i)
+		codes[i] = lens[i] ? reverse_bits(next_code[lens[i]]++, lens[i]) : 0;
+}
+
+void write_stored(BitWriter &bw, const unsigned char *raw, size_t n) {
+	do {
+		size_t len = min(n, size_t(65535));
+		bw.put(0, 3); // BFINAL = 0, BTYPE = 00
+		bw.align();
+		bw.put(len & 0xffff, 16);
+		bw.put(~len & 0xffff, 16);
+		bw.out.insert(bw.out.end(), raw, raw + len);
+		raw += len;
+		n -= len;
+	} while (n > 0);
+}
+
+// escreve um bloco com os tokens dados, escolhendo o menor entre Huffman
+// dinâmico, Huffman fixo e stored
+void write_block(BitWriter &bw, const Token *tok, size_t ntok, const unsigned char *raw, size_t rawlen) {
+	unsigned lfreq[286] = {0}, dfreq[30] = {0};
+	for (size_t i = 0; i < ntok; ++i) {
+		if (tok[i].dist == 0) {
+			lfreq[tok[i].len]++;
+		} else {
+			lfreq[257 + len_code[tok[i].len]]++;
+			dfreq[distance_code(tok[i].dist)]++;
+		}
+	}
+	lfreq[256] = 1;
+	// árvores com um símbolo só não são completas; força pelo menos dois
+	if (count_if(lfreq, lfreq + 286, [](unsigned f) { return f != 0; }) < 2)
+		lfreq[lfreq[0] ? 1 : 0]++;
+	int used_d = int(count_if(dfreq, dfreq + 30, [](unsigned f) { return f != 0; }));
+	if (used_d < 2) {
+		dfreq[0] += dfreq[0] ? 0 : 1;
+		dfreq[1] += dfreq[1] ? 0 : 1;
+	}
+
+	unsigned char llen[286], dlen[30];
+	build_lengths(lfreq, 286, 15, llen);
+	build_lengths(dfreq, 30, 15, dlen);
+
+	int hlit = 286, hdist = 30;
+	while (hlit > 257 && llen[hlit - 1] == 0)
+		--hlit;
+	while (hdist > 1 && dlen[hdist - 1] == 0)
+		--hdist;
+
+	// sequência de comprimentos codificada com os símbolos 16/17/18
+	unsigned char all[286 + 30];
+	memcpy(all, llen, hlit);
+	memcpy(all + hlit, dlen, hdist);
+	int total = hlit + hdist;
+	vector<pair<int, int>> clsyms; // (símbolo, bits extra)
+	unsigned cfreq[19] = {0};
+	for (int i = 0; i < total;) {
+		int v = all[i], run = 1;
+		while (i + run < total && all[i + run] == v)
+			++run;
+		int rem = run;
+		if (v == 0) {
+			while (rem >= 11) {
+				int r = min(rem, 138);
+				clsyms.push_back({18, r - 11});
+				rem -= r;
+			}
+			if (rem >= 3) {
+				clsyms.push_back({17, rem - 3});
+				rem = 0;
+			}
+		} else {
+			clsyms.push_back({v, 0});
+			--rem;
+			while (rem >= 3) {
+				int r = min(rem, 6);
+				clsyms.push_back({16, r - 3});
+				rem -= r;
+			}
+		}
+		for (; rem > 0; --rem)
+			clsyms.push_back({v, 0});
+		i += run;
+	}
+	for (auto &s : clsyms)
+		cfreq[s.first]++;
+	unsigned char clen[19];
+	build_lengths(cfreq, 19, 7, clen);
+	int hclen = 19;
+	while (hclen > 4 && clen[clen_order[hclen - 1]] == 0)
+		--hclen;
+
+	// custo em bits de cada alternativa
+	uint64_t dyn_bits = 3 + 14 + 3 * hclen, fix_bits = 3;
+	for (auto &s : clsyms)
+		dyn_bits += clen[s.first] + (s.first == 16 ? 2 : s.first == 17 ? 3 : s.first == 18 ? 7 : 0);
+	for (int s = 0; s < 286; ++s) {
+		uint64_t extra = s > 256 ? len_extra[s - 257] : 0;
+		dyn_bits += uint64_t(lfreq[s]) * (llen[s] + extra);
+		fix_bits += uint64_t(lfreq[s]) * (fixed_llen[s] + extra);
+	}
+	for (int s = 0; s < 30; ++s) {
+		dyn_bits += uint64_t(dfreq[s]) * (dlen[s] + dist_extra[s]);
+		fix_bits += uint64_t(dfreq[s]) * (fixed_dlen[s] + dist_extra[s]);
+	}
+	uint64_t stored_bits = (rawlen / 65535 + 1) * (3 + 7 + 32) + uint64_t(rawlen) * 8;
+
+	if (stored_bits <= dyn_bits && stored_bits <= fix_bits) {
+		write_stored(bw, raw, rawlen);
+		return;
+	}
+
+	unsigned short lcode[288], dcode[30];
+	const unsigned char *ll = llen, *dl = dlen;
+	if (fix_bits <= dyn_bits) {
+		bw.put(1 << 1, 3); // BFINAL = 0, BTYPE = 01
+		ll = fixed_llen;
+		dl = fixed_dlen;
+		build_codes(fixed_llen, 288, lcode);
+		build_codes(fixed_dlen, 30, dcode);
+	} else {
+		bw.put(2 << 1, 3); // BFINAL = 0, BTYPE = 10
+		bw.put(hlit - 257, 5);
+		bw.put(hdist - 1, 5);
+		bw.put(hclen - 4, 4);
+		for (int i = 0; i < hclen; ++i)
+			bw.put(clen[clen_order[i]], 3);
+		unsigned short ccode[19];
+		build_codes(clen, 19, ccode);
+		for (auto &s : clsyms) {
+			bw.put(ccode[s.first], clen[s.first]);
+			if (s.first == 16)
+				bw.put(s.second, 2);
+			else if (s.first == 17)
+				bw.put(s.second, 3);
+			else if (s.first == 18)
+				bw.put(s.second, 7);
+		}
+		build_codes(llen, 286, lcode);
+		build_codes(dlen, 30, dcode);
+	}
+
+	for (size_t i = 0; i < ntok; ++i) {
+		const Token &t = tok[i];
+		if (t.dist == 0) {
+			bw.put(lcode[t.len], ll[t.len]);
+			continue;
+		}
+		int lc = len_code[t.len];
+		bw.put(lcode[257 + lc], ll[257 + lc]);
+		bw.put(t.len - len_base[lc], len_extra[lc]);
+		int dc = distance_code(t.dist);
+		bw.put(dcode[dc], dl[dc]);
+		bw.put(t.dist - dist_base[dc], dist_extra[dc]);
+	}
+	bw.put(lcode[256], ll[256]);
+}
+
+// tamanho do prefixo comum de `a` e `b`, comparando 8 bytes por vez
+inline size_t match_length(const unsigned char *a, const unsigned char *b, size_t lim) {
+	size_t l = 0;
+	while (l + 8 <= lim) {
+		uint64_t x, y;
+		memcpy(&x, a + l, 8);
+		memcpy(&y, b + l, 8);
+		if (x != y)
+			return l + (__builtin_ctzll(x ^ y) >> 3);
+		l += 8;
+	}
+	while (l < lim && a[l] == b[l])
+		++l;
+	return l;
+}
+
+struct LevelParams {
+	int good;
+	int lazy; // 0 = sem avaliação preguiçosa
+	int nice;
+	int chain;
+};
+
+// mesmos parâmetros por nível do zlib: um match com `good` bytes reduz a busca
+// preguiçosa, um com `lazy` bytes dispensa a busca preguiçosa e um com `nice`
+// bytes encerra a cadeia
+const LevelParams level_params[10] = {{0, 0, 0, 0},       {4, 0, 8, 4},        {4, 0, 16, 8},     {4, 0, 32, 32},
+                                      {4, 4, 16, 16},     {8, 16, 32, 32},     {8, 16, 128, 128}, {8, 32, 128, 256},
+                                      {32, 128, 258, 1024}, {32, 258, 258, 4096}};
+
+// Gera os tokens LZ77 de `data`. No modo RLE só se procura a distância 1, o que
+// já captura as longas sequências de 0/255 de uma imagem pontilhada.
+void lz77(const unsigned char *data, size_t n, int level, bool rle, vector<Token> &tokens) {
+	tokens.clear();
+	tokens.reserve(n / 2 + 16);
+	if (rle) {
+		size_t i = 0;
+		while (i < n) {
+			size_t run = 0;
+			if (i > 0) {
+				size_t lim = min(n - i, size_t(MAX_MATCH));
+				while (run < lim && data[i + run] == data[i - 1])
+					++run;
+			}
+			if (run >= 3) {
+				tokens.push_back({(unsigned short)run, 1});
+				i += run;
+			} else {
+				tokens.push_back({data[i], 0});
+				++i;
+			}
+		}
+		return;
+	}
+
+	const LevelParams &p = level_params[max(1, min(level, 9))];
+	vector<int> head(1 << HASH_BITS, -1), prev(WINDOW, -1);
+	size_t inserted = 0;
+	auto hash = [&](size_t i) {
+		uint32_t v = data[i] | (data[i + 1] << 8) | (data[i + 2] << 16);
+		return (v * 2654435761u) >> (32 - HASH_BITS);
+	};
+	auto insert_until = [&](size_t pos) {
+		for (; inserted < pos; ++inserted) {
+			if (inserted + 2 >= n)
+				continue;
+			uint32_t h = hash(inserted);
+			prev[inserted & (WINDOW - 1)] = head[h];
+			head[h] = int(inserted);
+		}
+	};
+	auto find = [&](size_t i, int chain_len, int &best_len, int &best_dist) {
+		best_len = 0;
+		best_dist = 0;
+		if (i + 2 >= n)
+			return;
+		insert_until(i);
+		size_t lim = min(n - i, size_t(MAX_MATCH));
+		int cand = head[hash(i)];
+		for (int chain = chain_len; cand >= 0 && chain > 0; --chain) {
+			size_t dist = i - size_t(cand);
+			if (dist > size_t(WINDOW - MAX_MATCH))
+				break;
+			if (data[cand + best_len] == data[i + best_len] && data[cand] == data[i]) {
+				size_t l = match_length(data + cand, data + i, lim);
+				if (int(l) > best_len) {
+					best_len = int(l);
+					best_dist = int(dist);
+					if (best_len >= p.nice || l == lim)
+						break;
+				}
+			}
+			cand = prev[cand & (WINDOW - 1)];
+		}
+		if (best_len < 3)
+			best_len = 0;
+	};
+
+	size_t i = 0;
+	int len = 0, dist = 0;
+	bool have = false; // match já calculado para `i` (vindo do passo preguiçoso)
+	while (i < n) {
+		if (!have)
+			find(i, p.chain, len, dist);
+		have = false;
+		if (len && len < p.lazy && i + 1 < n) {
+			int len2, dist2;
+			find(i + 1, len >= p.good ? p.chain >> 2 : p.chain, len2, dist2);
+			if (len2 > len) {
+				tokens.push_back({data[i], 0});
+				++i;
+				len = len2;
+				dist = dist2;
+				have = true;
+				continue;
+			}
+		}
+		if (len) {
+			tokens.push_back({(unsigned short)len, (unsigned short)dist});
+			i += len;
+		} else {
+			tokens.push_back({data[i], 0});
+			++i;
+		}
+	}
+}
+
+// Comprime `data` como blocos deflate independentes. Se não for o último
+// trecho, termina com um bloco stored vazio (sync flush), deixando a saída
+// alinhada em byte e pronta para ser concatenada com o próximo trecho.
+void deflate_chunk(const unsigned char *data, size_t n, const PngOptions &opt, bool last, vector<unsigned char> &out) {
+	BitWriter bw(out);
+	if (opt.mode == PngMode::Stored) {
+		if (n > 0)
+			write_stored(bw, data, n);
+	} else {
+		vector<Token> tokens;
+		lz77(data, n, opt.level, opt.mode == PngMode::Rle, tokens);
+		size_t raw_pos = 0;
+		for (size_t t = 0; t < tokens.size(); t += TOKENS_PER_BLOCK) {
+			size_t nt = min(TOKENS_PER_BLOCK, tokens.size() - t);
+			size_t raw_len = 0;
+			for (size_t k = t; k < t + nt; ++k)
+				raw_len += tokens[k].dist ? tokens[k].len : 1;
+			write_block(bw, &tokens[t], nt, data + raw_pos, raw_len);
+			raw_pos += raw_len;
+		}
+	}
+	if (last) {
+		bw.put(1 | (1 << 1), 3); // bloco fixo final vazio: só o código 256 (7 zeros)
+		bw.put(0, 7);
+	} else {
+		bw.put(0, 3);
+		bw.align();
+		bw.put(0x0000, 16);
+		bw.put(0xffff, 16);
+	}
+	bw.align();
+}
+
+// ---------------------------------------------------------------------------
+// Filtros e empacotamento das linhas
+
+struct RowLayout {
+	int width, comp, bit_depth;
+	size_t rowbytes;
+	int bpp;
+
+	RowLayout(int w, int c, int depth) : width(w), comp(c), bit_depth(depth) {
+		rowbytes = depth == 1 ? size_t(w + 7) / 8 : size_t(w) * c;
+		bpp = depth == 1 ? 1 : c;
+	}
+
+	// converte uma linha de pixels para o formato do PNG (1 bit: branco = 1)
+	const unsigned char *pack(const unsigned char *src, unsigned char *tmp) const {
+		if (bit_depth != 1)
+			return src;
+		memset(tmp, 0, rowbytes);
+		for (int x = 0; x < width; ++x)
+			if (src[x] >= 128)
+				tmp[x >> 3] |= 0x80 >> (x & 7);
+		return tmp;
+	}
+};
+
+inline unsigned char paeth(int a, int b, int c) {
+	int p = a + b - c, pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+	if (pa <= pb && pa <= pc)
+		return a;
+	return pb <= pc ? b : c;
+}
+
+void apply_filter(int type, const unsigned char *cur, const unsigned char *prev, size_t n, int bpp, unsigned char *out) {
+	out[0] = (unsigned char)type;
+	++out;
+	for (size_t i = 0; i < n; ++i) {
+		int a = i >= size_t(bpp) ? cur[i - bpp] : 0;
+		int b = prev ? prev[i] : 0;
+		int c = (prev && i >= size_t(bpp)) ? prev[i - bpp] : 0;
+		switch (type) {
+		case 0:
+			out[i] = cur[i];
+			break;
+		case 1:
+			out[i] = cur[i] - a;
+			break;
+		case 2:
+			out[i] = cur[i] - b;
+			break;
+		case 3:
+			out[i] = cur[i] - ((a + b) >> 1);
+			break;
+		default:
+			out[i] = cur[i] - paeth(a, b, c);
+			break;
+		}
+	}
+}
+
+// Heurística de soma das diferenças absolutas com sinal (a mesma do libpng)
+size_t filter_cost(const unsigned char *f, size_t n) {
+	size_t cost = 0;
+	for (size_t i = 0; i < n; ++i)
+		cost += abs(int((signed char)f[i]));
+	return cost;
+}
+
+bool row_is_bilevel(const unsigned char *row, size_t n) {
+	for (size_t i = 0; i < n; ++i)
+		if (row[i] != 0 && row[i] != 255)
+			return false;
+	return true;
+}
+
+// filtra `nrows` linhas (já empacotadas) para `out`, com o byte de filtro de cada linha
+void filter_rows(const RowLayout &layout, const PngOptions &opt, const unsigned char *src, int stride, int nrows,
+                 const unsigned char *prev_packed, vector<unsigned char> &out) {
+	size_t n = layout.rowbytes;
+	out.resize((n + 1) * nrows);
+	vector<unsigned char> tmp_cur(n), tmp_prev(n), trial(n + 1);
+	const unsigned char *prev = prev_packed;
+	if (prev) {
+		memcpy(tmp_prev.data(), prev, n);
+		prev = tmp_prev.data();
+	}
+	vector<unsigned char> cur_copy(n);
+	for (int r = 0; r < nrows; ++r) {
+		const unsigned char *cur = layout.pack(src + size_t(r) * stride, tmp_cur.data());
+		unsigned char *dst = &out[(n + 1) * r];
+		if (opt.filter != PngFilter::Adaptive) {
+			apply_filter(int(opt.filter), cur, prev, n, layout.bpp, dst);
+		} else {
+			// Linhas pontilhadas (só 0/255, ou empacotadas em 1 bit) vão sem filtro:
+			// Sub/Up/Paeth transformam cada transição preto/branco em dois
+			// símbolos novos e atrapalham os matches do LZ77, enquanto a
+			// repetição entre linhas já é capturada pela distância de uma linha.
+			if (layout.bit_depth == 1 || row_is_bilevel(cur, n)) {
+				apply_filter(0, cur, prev, n, layout.bpp, dst);
+			} else {
+				size_t best = SIZE_MAX;
+				for (int type = 0; type < 5; ++type) {
+					apply_filter(type, cur, prev, n, layout.bpp, trial.data());
+					size_t cost = filter_cost(trial.data() + 1, n);
+					if (cost < best) {
+						best = cost;
+						memcpy(dst, trial.data(), n + 1);
+					}
+				}
+			}
+		}
+		memcpy(cur_copy.data(), cur, n);
+		swap(cur_copy, tmp_prev);
+		prev = tmp_prev.data();
+	}
+}
+
+// ---------------------------------------------------------------------------
+// Montagem do arquivo PNG
+
+void put_be32(vector<unsigned char> &out, uint32_t v) {
+	out.push_back(v >> 24);
+	out.push_back(v >> 16);
+	out.push_back(v >> 8);
+	out.push_back(v);
+}
+
+void put_chunk(vector<unsigned char> &out, const char *type, const unsigned char *data, size_t n) {
+	put_be32(out, uint32_t(n));
+	size_t start = out.size();
+	out.insert(out.end(), type, type + 4);
+	if (n)
+		out.insert(out.end(), data, data + n);
+	put_be32(out, crc32(0, &out[start], n + 4));
+}
+
+void put_header(vector<unsigned char> &out, int width, int height, int comp, int bit_depth) {
+	static const unsigned char sig[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+	static const unsigned char color_type[5] = {0, 0, 4, 2, 6};
+	out.insert(out.end(), sig, sig + 8);
+	vector<unsigned char> ihdr;
+	put_be32(ihdr, width);
+	put_be32(ihdr, height);
+	ihdr.push_back(bit_depth);
+	ihdr.push_back(color_type[comp]);
+	ihdr.push_back(0);
+	ihdr.push_back(0);
+	ihdr.push_back(0);
+	put_chunk(out, "IHDR", ihdr.data(), ihdr.size());
+}
+
+const unsigned char zlib_header[2] = {0x78, 0x01};
+
+int resolve_bit_depth(const unsigned char *pixels, int width, int height, int comp, int stride, int requested) {
+	if (comp != 1)
+		return 8;
+	if (requested == 1 || requested == 8)
+		return requested;
+	for (int y = 0; y < height; ++y)
+		if (!row_is_bilevel(pixels + size_t(y) * stride, width))
+			return 8;
+	return 1;
+}
+
+void stb_append(void *context, void *data, int size) {
+	auto *out = static_cast<vector<unsigned char> *>(context);
+	auto *p = static_cast<unsigned char *>(data);
+	out->insert(out->end(), p, p + size);
+}
+
+} // namespace
+
+bool png_mode_from_string(const char *name, PngMode &mode) {
+	string s = name;
+	if (s == "stb")
+		mode = PngMode::Stb;
+	else if (s == "stored")
+		mode = PngMode::Stored;
+	else if (s == "rle")
+		mode = PngMode::Rle;
+	else if (s == "deflate")
+		mode = PngMode::Deflate;
+	else
+		return false;
+	return true;
+}
+
+const char *png_mode_name(PngMode mode) {
+	switch (mode) {
+	case PngMode::Stb:
+		return "stb";
+	case PngMode::Stored:
+		return "stored";
+	case PngMode::Rle:
+		return "rle";
+	default:
+		return "deflate";
+	}
+}
+
+bool png_encode(vector<unsigned char> &out, const unsigned char *pixels, int width, int height, int comp, int stride,
+                const PngOptions &opt) {
+	out.clear();
+	if (width <= 0 || height <= 0 || comp < 1 || comp > 4)
+		return false;
+
+	if (opt.mode == PngMode::Stb) {
+		stbi_write_png_compression_level = opt.level;
+		stbi_write_force_png_filter = opt.filter == PngFilter::Adaptive ? -1 : int(opt.filter);
+		return stbi_write_png_to_func(stb_append, &out, width, height, comp, pixels, stride) != 0;
+	}
+
+	RowLayout layout(width, comp, resolve_bit_depth(pixels, width, height, comp, stride, opt.bit_depth));
+	int rows_per_block = max(1, opt.rows_per_block);
+	int nblocks = (height + rows_per_block - 1) / rows_per_block;
+
+	struct Block {
+		vector<unsigned char> z;
+		uint32_t adler;
+		size_t rawlen;
+	};
+	vector<Block> blocks(nblocks);
+	atomic<int> next(0);
+	auto worker = [&]() {
+		vector<unsigned char> filtered, prev_tmp(layout.rowbytes);
+		for (int b = next++; b < nblocks; b = next++) {
+			int y0 = b * rows_per_block, nrows = min(rows_per_block, height - y0);
+			const unsigned char *prev =
+			    y0 > 0 ? layout.pack(pixels + size_t(y0 - 1) * stride, prev_tmp.data()) : nullptr;
+			filter_rows(layout, opt, pixels + size_t(y0) * stride, stride, nrows, prev, filtered);
+			blocks[b].rawlen = filtered.size();
+			blocks[b].adler = adler32(1, filtered.data(), filtered.size());
+			deflate_chunk(filtered.data(), filtered.size(), opt, b == nblocks - 1, blocks[b].z);
+		}
+	};
+
+	int nthreads = opt.threads > 0 ? opt.threads : int(thread::hardware_concurrency());
+	nthreads = max(1, min(nthreads, nblocks));
+	vector<thread> pool;
+	for (int t = 1; t < nthreads; ++t)
+		pool.emplace_back(worker);
+	worker();
+	for (auto &t : pool)
+		t.join();
+
+	put_header(out, width, height, comp, layout.bit_depth);
+	uint32_t adler = 1;
+	for (int b = 0; b < nblocks; ++b) {
+		vector<unsigned char> &z = blocks[b].z;
+		adler = b == 0 ? blocks[b].adler : adler32_combine(adler, blocks[b].adler, blocks[b].rawlen);
+		if (b == 0)
+			z.insert(z.begin(), zlib_header, zlib_header + 2);
+		if (b == nblocks - 1)
+			put_be32(z, adler);
+		put_chunk(out, "IDAT", z.data(), z.size());
+	}
+	put_chunk(out, "IEND", nullptr, 0);
+	return true;
+}
+
+bool png_write(const char *filename, const unsigned char *pixels, int width, int height, int comp, int stride,
+               const PngOptions &opt) {
+	vector<unsigned char> out;
+	if (!png_encode(out, pixels, width, height, comp, stride, opt))
+		return false;
+	FILE *f = fopen(filename, "wb");
+	if (!f)
+		return false;
+	bool ok = fwrite(out.data(), 1, out.size(), f) == out.size();
+	return fclose(f) == 0 && ok;
+}
+
+PngStreamWriter::~PngStreamWriter() {
+	if (file)
+		fclose(file);
+}
+
+bool PngStreamWriter::open(const char *filename, int w, int h, int c, const PngOptions &o) {
+	if (w <= 0 || h <= 0 || c < 1 || c > 4)
+		return false;
+	file = fopen(filename, "wb");
+	if (!file)
+		return false;
+	width = w;
+	height = h;
+	comp = c;
+	opt = o;
+	if (opt.mode == PngMode::Stb)
+		opt.mode = PngMode::Deflate;
+	bit_depth = (comp == 1 && opt.bit_depth == 1) ? 1 : 8;
+	opt.rows_per_block = max(1, opt.rows_per_block);
+	rows_written = 0;
+	block_rows = 0;
+	adler = 1;
+	block.resize(size_t(opt.rows_per_block) * width * comp);
+	prev_row.clear();
+
+	vector<unsigned char> head;
+	put_header(head, width, height, comp, bit_depth);
+	return fwrite(head.data(), 1, head.size(), file) == head.size();
+}
+
+bool PngStreamWriter::write_rows(const unsigned char *rows, int nrows, int stride) {
+	if (!file || rows_written + block_rows + nrows > height)
+		return false;
+	size_t rowsize = size_t(width) * comp;
+	for (int r = 0; r < nrows; ++r) {
+		memcpy(&block[rowsize * block_rows], rows + size_t(r) * stride, rowsize);
+		if (++block_rows == opt.rows_per_block && !flush_block(rows_written + block_rows == height))
+			return false;
+	}
+	return true;
+}
+
+bool PngStreamWriter::flush_block(bool last) {
+	RowLayout layout(width, comp, bit_depth);
+	size_t rowsize = size_t(width) * comp;
+	vector<unsigned char> filtered, z;
+	filter_rows(layout, opt, block.data(), int(rowsize), block_rows, prev_row.empty() ? nullptr : prev_row.data(),
+	            filtered);
+	if (rows_written == 0)
+		z.insert(z.end(), zlib_header, zlib_header + 2);
+	deflate_chunk(filtered.data(), filtered.size(), opt, last, z);
+	uint32_t a = adler32(1, filtered.data(), filtered.size());
+	adler = rows_written == 0 ? a : adler32_combine(adler, a, filtered.size());
+	if (last)
+		put_be32(z, adler);
+
+	prev_row.resize(layout.rowbytes);
+	const unsigned char *packed = layout.pack(&block[rowsize * (block_rows - 1)], prev_row.data());
+	if (packed != prev_row.data())
+		memcpy(prev_row.data(), packed, layout.rowbytes);
+
+	rows_written += block_rows;
+	block_rows = 0;
+	vector<unsigned char> chunk;
+	put_chunk(chunk, "IDAT", z.data(), z.size());
+	return fwrite(chunk.data(), 1, chunk.size(), file) == chunk.size();
+}
+
+bool PngStreamWriter::close() {
+	if (!file)
+		return false;
+	bool ok = true;
+	if (block_rows > 0)
+		ok = flush_block(true);
+	ok = ok && rows_written == height;
+	vector<unsigned char> tail;
+	put_chunk(tail, "IEND", nullptr, 0);
+	ok = ok && fwrite(tail.data(), 1, tail.size(), file) == tail.size();
+	ok = (fclose(file) == 0) && ok;
+	file = nullptr;
+	return ok;
+}
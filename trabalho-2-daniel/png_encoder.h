@@ -0,0 +1,66 @@
+#ifndef PNG_ENCODER_H
+#define PNG_ENCODER_H
+
+#include <cstdio>
+#include <vector>
+
+// Modos de codificação do PNG
+enum class PngMode {
+	Stb,     // stbi_write_png (referência)
+	Stored,  // deflate sem compressão: caminho mais rápido
+	Rle,     // só matches de distância 1 (como o Z_RLE do zlib) + Huffman dinâmico
+	Deflate, // LZ77 com cadeia de hash + Huffman dinâmico
+};
+
+// Filtros de linha do PNG; Adaptive escolhe por linha
+enum class PngFilter { None = 0, Sub = 1, Up = 2, Avg = 3, Paeth = 4, Adaptive = 5 };
+
+struct PngOptions {
+	PngMode mode = PngMode::Deflate;
+	int level = 6; // 1..9 (Deflate e Stb)
+	PngFilter filter = PngFilter::Adaptive;
+	int threads = 0; // 0 = std::thread::hardware_concurrency()
+	int rows_per_block = 64; // blocos de linhas comprimidos de forma independente
+	int bit_depth = 0; // 0 = detecta (1 bit se a imagem só tem 0 e 255), 1 ou 8
+};
+
+// converte "stb", "stored", "rle" ou "deflate" para o modo correspondente
+bool png_mode_from_string(const char *name, PngMode &mode);
+const char *png_mode_name(PngMode mode);
+
+// codifica a imagem inteira em memória; os blocos de linhas são filtrados e
+// comprimidos em paralelo e depois concatenados num único fluxo zlib
+bool png_encode(std::vector<unsigned char> &out, const unsigned char *pixels, int width, int height, int comp,
+                int stride, const PngOptions &opt);
+bool png_write(const char *filename, const unsigned char *pixels, int width, int height, int comp, int stride,
+               const PngOptions &opt);
+
+// Escrita incremental: as linhas são acumuladas em blocos de `rows_per_block`,
+// e cada bloco vira um chunk IDAT assim que completo. A memória fica limitada a
+// um bloco de linhas mais a saída comprimida desse bloco. O modo Stb não é
+// suportado aqui (cai para Deflate) e bit_depth 0 é tratado como 8.
+class PngStreamWriter {
+public:
+	PngStreamWriter() = default;
+	~PngStreamWriter();
+	PngStreamWriter(const PngStreamWriter &) = delete;
+	PngStreamWriter &operator=(const PngStreamWriter &) = delete;
+
+	bool open(const char *filename, int width, int height, int comp, const PngOptions &opt);
+	bool write_rows(const unsigned char *rows, int nrows, int stride);
+	bool close();
+
+private:
+	bool flush_block(bool last);
+
+	std::FILE *file = nullptr;
+	PngOptions opt;
+	int width = 0, height = 0, comp = 1, bit_depth = 8;
+	int rows_written = 0;
+	unsigned adler = 1;
+	std::vector<unsigned char> block; // linhas cruas do bloco atual
+	std::vector<unsigned char> prev_row; // última linha do bloco anterior (para Up/Avg/Paeth)
+	int block_rows = 0;
+};
+
+#endif
@@ -0,0 +1,162 @@
+#include "dither.h"
+#include "palette_cache.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+int nearest(const Palette &palette, const Lab &pixel) {
+	if (palette.accel)
+		return palette.accel->nearest(pixel);
+	return find_nearest_color(pixel, palette.lab.data, int(palette.lab.size));
+}
+
+} // namespace
+
+void rgb_to_lab(ImageSpan<const RGB> in, ImageSpan<Lab> out) {
+	for (int y = 0; y < in.height; ++y) {
+		const RGB *src = in.row(y);
+		Lab *dst = out.row(y);
+		for (int x = 0; x < in.width; ++x)
+			dst[x] = rgb2Lab(src[x]);
+	}
+}
+
+void rgb_to_lab(Span<const RGB> in, Span<Lab> out) {
+	size_t n = std::min(in.size, out.size);
+	for (size_t i = 0; i < n; ++i)
+		out[i] = rgb2Lab(in[i]);
+}
+
+void quantize(ImageSpan<const RGB> in, const Palette &palette, ImageSpan<RGB> out) {
+	for (int y = 0; y < in.height; ++y) {
+		const RGB *src = in.row(y);
+		RGB *dst = out.row(y);
+		for (int x = 0; x < in.width; ++x) {
+			int pi = nearest(palette, rgb2Lab(src[x]));
+			dst[x] = palette.rgb[pi];
+		}
+	}
+}
+
+size_t atkinson_scratch_size(int width) {
+	return 3 * size_t(width);
+}
+
+bool atkinson_dither(ImageSpan<const RGB> in, const Palette &palette, ImageSpan<RGB> out, Span<Lab> scratch) {
+	const int width = in.width, height = in.height;
+	if (palette.lab.size == 0 || palette.rgb.size < palette.lab.size || out.width != width ||
+	    out.height != height || scratch.size < atkinson_scratch_size(width))
+		return false;
+
+	// Linhas y, y+1 e y+2 em Lab, num buffer circular: a linha y+2 é
+	// convertida antes de receber qualquer erro, como no buffer completo
+	Lab *rows[3] = {scratch.data, scratch.data + width, scratch.data + 2 * width};
+	auto load = [&](int y) {
+		if (y >= height)
+			return;
+		const RGB *src = in.row(y);
+		Lab *dst = rows[y % 3];
+		for (int x = 0; x < width; ++x)
+			dst[x] = rgb2Lab(src[x]);
+	};
+
+	// Kernel de Atkinson
+	const int dx[6] = {1, 2, -1, 0, 1, 0};
+	const int dy[6] = {0, 0, 1, 1, 1, 2};
+
+	load(0);
+	load(1);
+	for (int y = 0; y < height; ++y) {
+		load(y + 2);
+		Lab *cur = rows[y % 3];
+		RGB *dst = out.row(y);
+		for (int x = 0; x < width; ++x) {
+			Lab oldLab = cur[x];
+			int pi = nearest(palette, oldLab);
+			Lab best = palette.lab[pi];
+
+			// Convertendo paleta de volta a RGB
+			dst[x] = palette.rgb[pi];
+
+			// Erro em Lab
+			Lab err;
+			err.L = (oldLab.L - best.L) / 8.0f;
+			err.a = (oldLab.a - best.a) / 8.0f;
+			err.b = (oldLab.b - best.b) / 8.0f;
+			// Fixar pixel
+			cur[x] = best;
+			// Difundir erro
+			for (int k = 0; k < 6; ++k) {
+				int nx = x + dx[k];
+				int ny = y + dy[k];
+
+				if (nx < 0 || nx >= width || ny >= height)
+					continue;
+
+				Lab &n = rows[ny % 3][nx];
+				n.L += err.L;
+				n.a += err.a;
+				n.b += err.b;
+			}
+		}
+	}
+	return true;
+}
+
+namespace {
+
+unsigned char clamp_byte(int v) {
+	return (unsigned char)std::max(0, std::min(v, 255));
+}
+
+// quantiza `cur` em 0/255 e difunde o erro nela mesma e em `next` (nullptr na última linha)
+void floyd_steinberg_row(unsigned char *cur, unsigned char *next, int width) {
+	for (int x = 0; x < width; ++x) {
+		int old = cur[x];
+		int new_pixel = old < 128 ? 0 : 255;
+		cur[x] = new_pixel;
+		int erro = old - new_pixel;
+		if (x + 1 < width)
+			cur[x + 1] = clamp_byte(cur[x + 1] + erro * 7 / 16);
+		if (!next)
+			continue;
+		if (x > 0)
+			next[x - 1] = clamp_byte(next[x - 1] + erro * 3 / 16);
+		next[x] = clamp_byte(next[x] + erro * 5 / 16);
+		if (x + 1 < width)
+			next[x + 1] = clamp_byte(next[x + 1] + erro * 1 / 16);
+	}
+}
+
+} // namespace
+
+void floyd_steinberg_gray(ImageSpan<const unsigned char> in, ImageSpan<unsigned char> out) {
+	const int width = in.width, height = in.height;
+	auto copy_row = [&](int y) {
+		if (y < height && in.row(y) != out.row(y))
+			std::memcpy(out.row(y), in.row(y), width);
+	};
+	copy_row(0);
+	for (int y = 0; y < height; ++y) {
+		copy_row(y + 1);
+		floyd_steinberg_row(out.row(y), y + 1 < height ? out.row(y + 1) : nullptr, width);
+	}
+}
+
+std::vector<Lab> palette_to_lab(const std::vector<RGB> &colors) {
+	std::vector<Lab> lab(colors.size());
+	rgb_to_lab(Span<const RGB>(colors), Span<Lab>(lab));
+	return lab;
+}
+
+void atkinsonDither(const std::vector<RGB> &inData, std::vector<RGB> &outData, int width, int height) {
+	// Paleta em Lab, reaproveitada do cache entre chamadas
+	const int grayLevels = 1024;
+	auto palette = PaletteCache::instance().get_gray(grayLevels);
+
+	outData.resize(size_t(width) * height);
+	std::vector<Lab> scratch(atkinson_scratch_size(width));
+	atkinson_dither(ImageSpan<const RGB>(inData.data(), width, height), palette->view(),
+	                ImageSpan<RGB>(outData.data(), width, height), scratch);
+}
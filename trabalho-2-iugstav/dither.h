@@ -0,0 +1,72 @@
+#ifndef DITHER_H
+#define DITHER_H
+
+#include "color.h"
+#include <cstddef>
+#include <vector>
+
+// Interface da libdither. As funções com spans não alocam nada: a entrada, a
+// saída e a memória de trabalho (scratch) são de quem chama, e podem ser
+// reaproveitadas entre chamadas.
+
+// trecho contíguo de elementos, sem posse
+template <typename T> struct Span {
+	T *data = nullptr;
+	size_t size = 0;
+
+	Span() = default;
+	Span(T *d, size_t n) : data(d), size(n) {}
+	template <typename U> Span(std::vector<U> &v) : data(v.data()), size(v.size()) {}
+	template <typename U> Span(const std::vector<U> &v) : data(v.data()), size(v.size()) {}
+
+	T &operator[](size_t i) const { return data[i]; }
+};
+
+// imagem sem posse; `stride` é a distância entre linhas em elementos (não bytes)
+template <typename T> struct ImageSpan {
+	T *data = nullptr;
+	int width = 0;
+	int height = 0;
+	std::ptrdiff_t stride = 0;
+
+	ImageSpan() = default;
+	ImageSpan(T *d, int w, int h) : data(d), width(w), height(h), stride(w) {}
+	ImageSpan(T *d, int w, int h, std::ptrdiff_t s) : data(d), width(w), height(h), stride(s) {}
+	template <typename U>
+	ImageSpan(const ImageSpan<U> &o) : data(o.data), width(o.width), height(o.height), stride(o.stride) {}
+
+	T *row(int y) const { return data + y * stride; }
+};
+
+struct PaletteData;
+
+// paleta com as cores em RGB e as mesmas cores já convertidas para Lab;
+// `accel`, quando presente (PaletteData::view()), acelera a busca da cor mais próxima
+struct Palette {
+	Span<const RGB> rgb;
+	Span<const Lab> lab;
+	const PaletteData *accel = nullptr;
+};
+
+// conversão RGB -> Lab de uma imagem
+void rgb_to_lab(ImageSpan<const RGB> in, ImageSpan<Lab> out);
+void rgb_to_lab(Span<const RGB> in, Span<Lab> out);
+
+// quantização sem difusão de erro: cada pixel vira a cor mais próxima da paleta
+void quantize(ImageSpan<const RGB> in, const Palette &palette, ImageSpan<RGB> out);
+
+// Atkinson em Lab. O erro vai até duas linhas abaixo, então o scratch guarda
+// três linhas em Lab (atkinson_scratch_size(width) elementos).
+size_t atkinson_scratch_size(int width);
+bool atkinson_dither(ImageSpan<const RGB> in, const Palette &palette, ImageSpan<RGB> out, Span<Lab> scratch);
+
+// Floyd–Steinberg binário (0/255) em tons de cinza, com o erro acumulado nos
+// próprios pixels de `out`; não precisa de scratch. `in` e `out` podem ser a
+// mesma imagem.
+void floyd_steinberg_gray(ImageSpan<const unsigned char> in, ImageSpan<unsigned char> out);
+
+// versões que alocam, para uso simples
+std::vector<Lab> palette_to_lab(const std::vector<RGB> &colors);
+void atkinsonDither(const std::vector<RGB> &inData, std::vector<RGB> &outData, int width, int height);
+
+#endif
@@ -0,0 +1,277 @@
+#include "dither.h"
+#include "ditherd_protocol.h"
+#include "palette_cache.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <memory>
+#include <mutex>
+#include <poll.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// Daemon de dithering: mantém paletas, buffers e threads quentes entre pedidos.
+// uso: ./ditherd [socket] [threads]
+
+namespace {
+
+std::atomic<bool> running(true);
+
+void on_signal(int) {
+	running = false;
+}
+
+// imagens com até este número de pixels são agrupadas num mesmo lote
+const long SMALL_IMAGE_PIXELS = 256 * 256;
+const int MAX_BATCH = 16;
+
+// buffer compartilhado anexado por um cliente
+struct Mapping {
+	unsigned char *data = nullptr;
+	size_t size = 0;
+};
+
+struct Connection {
+	int fd;
+	std::mutex write_mutex;
+	std::vector<Mapping> buffers; // só a thread da conexão altera
+
+	explicit Connection(int f) : fd(f) {}
+	~Connection() {
+		for (auto &m : buffers)
+			munmap(m.data, m.size);
+		close(fd);
+	}
+
+	void reply(const DitherReply &r) {
+		std::lock_guard<std::mutex> lock(write_mutex);
+		send(fd, &r, sizeof(r), MSG_NOSIGNAL);
+	}
+};
+
+struct Job {
+	std::shared_ptr<Connection> conn;
+	DitherRequest req;
+	Mapping buffer;
+};
+
+std::mutex queue_mutex;
+std::condition_variable queue_cv;
+std::deque<Job> queue;
+
+bool is_small(const Job &j) {
+	return long(j.req.width) * j.req.height <= SMALL_IMAGE_PIXELS;
+}
+
+size_t bytes_per_pixel(uint32_t algorithm) {
+	return algorithm == DITHER_FLOYD_STEINBERG ? 1 : sizeof(RGB);
+}
+
+int run_job(const Job &job, std::vector<Lab> &scratch) {
+	const DitherRequest &r = job.req;
+	if (r.width <= 0 || r.height <= 0 || r.algorithm > DITHER_FLOYD_STEINBERG)
+		return -1;
+	size_t bytes = size_t(r.width) * r.height * bytes_per_pixel(r.algorithm);
+	if (r.in_offset > job.buffer.size || bytes > job.buffer.size - r.in_offset || r.out_offset > job.buffer.size ||
+	    bytes > job.buffer.size - r.out_offset)
+		return -2;
+	unsigned char *in = job.buffer.data + r.in_offset, *out = job.buffer.data + r.out_offset;
+
+	if (r.algorithm == DITHER_FLOYD_STEINBERG) {
+		floyd_steinberg_gray(ImageSpan<const unsigned char>(in, r.width, r.height),
+		                     ImageSpan<unsigned char>(out, r.width, r.height));
+		return 0;
+	}
+
+	if (r.levels < 2 || r.levels > 65536)
+		return -1;
+	auto pal = PaletteCache::instance().get_gray(r.levels);
+	Palette palette = pal->view();
+	ImageSpan<const RGB> src(reinterpret_cast<const RGB *>(in), r.width, r.height);
+	ImageSpan<RGB> dst(reinterpret_cast<RGB *>(out), r.width, r.height);
+	if (r.algorithm == DITHER_QUANTIZE) {
+		quantize(src, palette, dst);
+		return 0;
+	}
+	if (scratch.size() < atkinson_scratch_size(r.width))
+		scratch.resize(atkinson_scratch_size(r.width));
+	return atkinson_dither(src, palette, dst, scratch) ? 0 : -1;
+}
+
+// Cada worker pega um pedido grande sozinho ou um lote de até MAX_BATCH
+// pedidos pequenos consecutivos, o que amortiza acordar a thread e a
+// disputa pela fila quando chegam muitas imagens pequenas.
+void worker() {
+	std::vector<Lab> scratch; // reaproveitado entre pedidos
+	std::vector<Job> batch;
+	for (;;) {
+		batch.clear();
+		{
+			std::unique_lock<std::mutex> lock(queue_mutex);
+			queue_cv.wait(lock, [] { return !queue.empty() || !running; });
+			if (queue.empty())
+				return;
+			batch.push_back(std::move(queue.front()));
+			queue.pop_front();
+			if (is_small(batch[0]))
+				while (!queue.empty() && int(batch.size()) < MAX_BATCH && is_small(queue.front())) {
+					batch.push_back(std::move(queue.front()));
+					queue.pop_front();
+				}
+		}
+		for (const Job &job : batch) {
+			auto t0 = std::chrono::steady_clock::now();
+			int status = run_job(job, scratch);
+			auto t1 = std::chrono::steady_clock::now();
+			DitherReply r{job.req.id, status, job.req.buffer, uint32_t(batch.size()),
+			              uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count())};
+			job.conn->reply(r);
+		}
+	}
+}
+
+// recebe um pedido e, se houver, o descritor anexado; só o primeiro
+// descritor recebido vale, os demais (no mesmo SCM_RIGHTS ou em outra parte
+// do pedido) são fechados
+bool receive_request(int fd, DitherRequest &req, int &passed_fd) {
+	passed_fd = -1;
+	char control[CMSG_SPACE(16 * sizeof(int))];
+	size_t got = 0;
+	while (got < sizeof(req)) {
+		iovec iov{reinterpret_cast<char *>(&req) + got, sizeof(req) - got};
+		msghdr msg{};
+		msg.msg_iov = &iov;
+		msg.msg_iovlen = 1;
+		msg.msg_control = control;
+		msg.msg_controllen = sizeof(control);
+		ssize_t n = recvmsg(fd, &msg, MSG_CMSG_CLOEXEC);
+		for (cmsghdr *c = CMSG_FIRSTHDR(&msg); c; c = CMSG_NXTHDR(&msg, c))
+			if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_RIGHTS) {
+				size_t count = (c->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+				for (size_t k = 0; k < count; ++k) {
+					int received;
+					memcpy(&received, CMSG_DATA(c) + k * sizeof(int), sizeof(int));
+					if (passed_fd < 0)
+						passed_fd = received;
+					else
+						close(received);
+				}
+			}
+		if (n <= 0) {
+			if (passed_fd >= 0)
+				close(passed_fd);
+			passed_fd = -1;
+			return false;
+		}
+		got += size_t(n);
+	}
+	return req.magic == DITHERD_MAGIC;
+}
+
+void serve_connection(std::shared_ptr<Connection> conn) {
+	DitherRequest req;
+	int passed_fd;
+	while (running && receive_request(conn->fd, req, passed_fd)) {
+		if (req.type == DITHER_ATTACH) {
+			DitherReply r{req.id, -1, 0, 0, 0};
+			// o tamanho pedido tem de caber no arquivo, e o arquivo não pode
+			// encolher depois (selo F_SEAL_SHRINK): acessar além do fim daria
+			// SIGBUS no worker, derrubando o daemon com todos os clientes
+			// (fcntl devolve -1 em arquivos sem suporte a selos)
+			struct stat st;
+			const int seals = passed_fd >= 0 ? fcntl(passed_fd, F_GET_SEALS) : -1;
+			if (passed_fd >= 0 && req.size > 0 && seals >= 0 && (seals & F_SEAL_SHRINK) != 0 &&
+			    fstat(passed_fd, &st) == 0 && uint64_t(st.st_size) >= req.size) {
+				void *p = mmap(nullptr, req.size, PROT_READ | PROT_WRITE, MAP_SHARED, passed_fd, 0);
+				if (p != MAP_FAILED) {
+					conn->buffers.push_back({static_cast<unsigned char *>(p), size_t(req.size)});
+					r.status = 0;
+					r.buffer = uint32_t(conn->buffers.size() - 1);
+				}
+			}
+			if (passed_fd >= 0)
+				close(passed_fd);
+			conn->reply(r);
+			continue;
+		}
+		if (passed_fd >= 0)
+			close(passed_fd);
+		if (req.type != DITHER_JOB || req.buffer >= conn->buffers.size()) {
+			conn->reply({req.id, -1, req.buffer, 0, 0});
+			continue;
+		}
+		{
+			std::lock_guard<std::mutex> lock(queue_mutex);
+			queue.push_back({conn, req, conn->buffers[req.buffer]});
+		}
+		queue_cv.notify_one();
+	}
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+	std::string path = argc > 1 ? argv[1] : DITHERD_DEFAULT_SOCKET;
+	int nthreads = argc > 2 ? atoi(argv[2]) : int(std::thread::hardware_concurrency());
+	nthreads = std::max(1, nthreads);
+
+	int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	sockaddr_un addr{};
+	addr.sun_family = AF_UNIX;
+	if (listen_fd < 0 || path.size() >= sizeof(addr.sun_path)) {
+		fprintf(stderr, "Erro ao criar o socket %s\n", path.c_str());
+		return 1;
+	}
+	strcpy(addr.sun_path, path.c_str());
+	unlink(path.c_str());
+	if (bind(listen_fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0 || listen(listen_fd, 64) < 0) {
+		perror("bind/listen");
+		return 1;
+	}
+
+	signal(SIGINT, on_signal);
+	signal(SIGTERM, on_signal);
+
+	// aquece a paleta padrão antes do primeiro pedido
+	PaletteCache::instance().get_gray(1024);
+
+	std::vector<std::thread> workers;
+	for (int i = 0; i < nthreads; ++i)
+		workers.emplace_back(worker);
+	printf("ditherd ouvindo em %s com %d threads\n", path.c_str(), nthreads);
+	fflush(stdout);
+
+	while (running) {
+		pollfd p{listen_fd, POLLIN, 0};
+		if (poll(&p, 1, 200) <= 0)
+			continue;
+		int fd = accept(listen_fd, nullptr, nullptr);
+		if (fd < 0)
+			continue;
+		std::thread(serve_connection, std::make_shared<Connection>(fd)).detach();
+	}
+
+	queue_cv.notify_all();
+	for (auto &t : workers)
+		t.join();
+	close(listen_fd);
+	unlink(path.c_str());
+
+	PaletteCache::Stats cs = PaletteCache::instance().stats();
+	printf("cache de paletas: %llu acertos, %llu faltas, %llu descartes, %zu entradas, %zu bytes\n",
+	       (unsigned long long)cs.hits, (unsigned long long)cs.misses, (unsigned long long)cs.evictions, cs.entries,
+	       cs.bytes);
+	return 0;
+}
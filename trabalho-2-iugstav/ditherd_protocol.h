@@ -0,0 +1,51 @@
+#ifndef DITHERD_PROTOCOL_H
+#define DITHERD_PROTOCOL_H
+
+#include <cstdint>
+
+// Protocolo entre o ditherd e seus clientes, por socket UNIX (SOCK_STREAM).
+//
+// As imagens nunca passam pelo socket: o cliente cria um memfd, anexa-o ao
+// daemon com DITHER_ATTACH (o descritor vai junto via SCM_RIGHTS) e depois
+// manda pedidos DITHER_JOB com deslocamentos dentro desse buffer. O daemon lê
+// a entrada e escreve a saída direto na memória compartilhada. O memfd
+// precisa ter pelo menos `size` bytes e o selo F_SEAL_SHRINK, para não
+// encolher enquanto o daemon o usa.
+
+const char *const DITHERD_DEFAULT_SOCKET = "/tmp/ditherd.sock";
+const uint32_t DITHERD_MAGIC = 0x44495448; // "DITH"
+
+enum DitherMessage : uint32_t {
+	DITHER_ATTACH = 1, // anexa o memfd enviado junto; `size` é o tamanho do buffer, até o do arquivo
+	DITHER_JOB = 2,
+};
+
+enum DitherAlgorithm : uint32_t {
+	DITHER_ATKINSON = 0, // RGB -> RGB, paleta de `levels` tons de cinza
+	DITHER_QUANTIZE = 1, // RGB -> RGB, sem difusão de erro
+	DITHER_FLOYD_STEINBERG = 2, // cinza (1 byte) -> cinza 0/255
+};
+
+struct DitherRequest {
+	uint32_t magic;
+	uint32_t type;
+	uint32_t id; // devolvido na resposta
+	uint32_t buffer; // índice devolvido pelo DITHER_ATTACH
+	uint32_t algorithm;
+	int32_t width;
+	int32_t height;
+	int32_t levels;
+	uint64_t in_offset;
+	uint64_t out_offset;
+	uint64_t size;
+};
+
+struct DitherReply {
+	uint32_t id;
+	int32_t status; // 0 = ok
+	uint32_t buffer;
+	uint32_t batch; // quantos pedidos o worker processou junto com este
+	uint64_t service_ns; // tempo de processamento no daemon
+};
+
+#endif
@@ -0,0 +1,176 @@
+#include "color.h"
+#include "ditherd_protocol.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// Gerador de carga para o ditherd: cada conexão anexa um memfd com uma imagem
+// sintética e manda pedidos em sequência, medindo a latência de ida e volta.
+// uso: ./ditherload [socket] [conexoes] [pedidos por conexao] [largura] [altura] [algoritmo 0|1|2] [niveis]
+
+namespace {
+
+bool send_all(int fd, const void *data, size_t n) {
+	const char *p = static_cast<const char *>(data);
+	while (n > 0) {
+		ssize_t k = send(fd, p, n, MSG_NOSIGNAL);
+		if (k <= 0)
+			return false;
+		p += k;
+		n -= size_t(k);
+	}
+	return true;
+}
+
+bool recv_all(int fd, void *data, size_t n) {
+	char *p = static_cast<char *>(data);
+	while (n > 0) {
+		ssize_t k = recv(fd, p, n, 0);
+		if (k <= 0)
+			return false;
+		p += k;
+		n -= size_t(k);
+	}
+	return true;
+}
+
+bool send_with_fd(int fd, const DitherRequest &req, int passed_fd) {
+	iovec iov{const_cast<DitherRequest *>(&req), sizeof(req)};
+	char control[CMSG_SPACE(sizeof(int))] = {};
+	msghdr msg{};
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+	cmsghdr *c = CMSG_FIRSTHDR(&msg);
+	c->cmsg_level = SOL_SOCKET;
+	c->cmsg_type = SCM_RIGHTS;
+	c->cmsg_len = CMSG_LEN(sizeof(int));
+	memcpy(CMSG_DATA(c), &passed_fd, sizeof(int));
+	return sendmsg(fd, &msg, MSG_NOSIGNAL) == ssize_t(sizeof(req));
+}
+
+struct Params {
+	std::string path;
+	int requests, width, height, levels;
+	uint32_t algorithm;
+};
+
+// roda uma conexão e devolve as latências em microssegundos (vazio em caso de erro)
+std::vector<double> run_client(const Params &p, int seed) {
+	std::vector<double> lat;
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	sockaddr_un addr{};
+	addr.sun_family = AF_UNIX;
+	strncpy(addr.sun_path, p.path.c_str(), sizeof(addr.sun_path) - 1);
+	if (fd < 0 || connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0) {
+		perror("connect");
+		return lat;
+	}
+
+	size_t bpp = p.algorithm == DITHER_FLOYD_STEINBERG ? 1 : sizeof(RGB);
+	size_t bytes = size_t(p.width) * p.height * bpp;
+	// o daemon só aceita memfds que não podem mais encolher
+	int mfd = memfd_create("ditherload", MFD_ALLOW_SEALING);
+	if (mfd < 0 || ftruncate(mfd, off_t(2 * bytes)) < 0 || fcntl(mfd, F_ADD_SEALS, F_SEAL_SHRINK) < 0) {
+		perror("memfd");
+		close(fd);
+		return lat;
+	}
+	void *mapped = mmap(nullptr, 2 * bytes, PROT_READ | PROT_WRITE, MAP_SHARED, mfd, 0);
+	if (mapped == MAP_FAILED) {
+		perror("mmap");
+		close(mfd);
+		close(fd);
+		return lat;
+	}
+	auto *mem = static_cast<unsigned char *>(mapped);
+	srand(seed);
+	for (size_t i = 0; i < bytes; ++i)
+		mem[i] = (unsigned char)((i * 7 + rand() % 32) & 0xff);
+
+	DitherRequest req{};
+	req.magic = DITHERD_MAGIC;
+	req.type = DITHER_ATTACH;
+	req.size = 2 * bytes;
+	DitherReply rep;
+	if (!send_with_fd(fd, req, mfd) || !recv_all(fd, &rep, sizeof(rep)) || rep.status != 0) {
+		fprintf(stderr, "falha ao anexar o buffer\n");
+		close(fd);
+		return lat;
+	}
+	close(mfd);
+
+	req.type = DITHER_JOB;
+	req.buffer = rep.buffer;
+	req.algorithm = p.algorithm;
+	req.width = p.width;
+	req.height = p.height;
+	req.levels = p.levels;
+	req.in_offset = 0;
+	req.out_offset = bytes;
+	for (int i = 0; i < p.requests; ++i) {
+		req.id = uint32_t(i);
+		auto t0 = std::chrono::steady_clock::now();
+		if (!send_all(fd, &req, sizeof(req)) || !recv_all(fd, &rep, sizeof(rep)) || rep.status != 0) {
+			fprintf(stderr, "pedido %d falhou\n", i);
+			break;
+		}
+		auto t1 = std::chrono::steady_clock::now();
+		lat.push_back(std::chrono::duration<double, std::micro>(t1 - t0).count());
+	}
+	munmap(mem, 2 * bytes);
+	close(fd);
+	return lat;
+}
+
+double percentile(const std::vector<double> &sorted, double q) {
+	if (sorted.empty())
+		return 0.0;
+	size_t i = std::min(sorted.size() - 1, size_t(q * (sorted.size() - 1) + 0.5));
+	return sorted[i];
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+	Params p;
+	p.path = argc > 1 ? argv[1] : DITHERD_DEFAULT_SOCKET;
+	int connections = argc > 2 ? atoi(argv[2]) : 4;
+	p.requests = argc > 3 ? atoi(argv[3]) : 200;
+	p.width = argc > 4 ? atoi(argv[4]) : 128;
+	p.height = argc > 5 ? atoi(argv[5]) : 128;
+	p.algorithm = argc > 6 ? uint32_t(atoi(argv[6])) : DITHER_ATKINSON;
+	p.levels = argc > 7 ? atoi(argv[7]) : 1024;
+
+	std::vector<std::vector<double>> results(connections);
+	std::vector<std::thread> threads;
+	auto t0 = std::chrono::steady_clock::now();
+	for (int c = 0; c < connections; ++c)
+		threads.emplace_back([&, c] { results[c] = run_client(p, c + 1); });
+	for (auto &t : threads)
+		t.join();
+	double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+	std::vector<double> all;
+	for (auto &r : results)
+		all.insert(all.end(), r.begin(), r.end());
+	std::sort(all.begin(), all.end());
+	double mpix = double(all.size()) * p.width * p.height / 1e6;
+	printf("%d conexoes x %d pedidos, %dx%d, algoritmo %u\n", connections, p.requests, p.width, p.height,
+	       p.algorithm);
+	printf("concluidos: %zu\n", all.size());
+	printf("latencia p50: %.1f us  p99: %.1f us\n", percentile(all, 0.50), percentile(all, 0.99));
+	printf("vazao: %.1f imagens/s  %.2f Mpixel/s\n", all.size() / elapsed, mpix / elapsed);
+	return all.size() == size_t(connections) * p.requests ? 0 : 1;
+}
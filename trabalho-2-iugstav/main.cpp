@@ -1,70 +1,21 @@
-#include "color.h"
+#include "dither.h"
 #include "image.h"
-#include <cmath>
+#include <string>
 
-void atkinsonDither(const std::vector<RGB> &inData, std::vector<RGB> &outData, int width, int height) {
-	int npix = width * height;
-	std::vector<Lab> buf(npix);
-	for (int i = 0; i < npix; ++i)
-		buf[i] = rgb2Lab(inData[i]);
+// uso: ./main [entrada.ppm] [saida.ppm]
+int main(int argc, char **argv) {
+	std::string input = argc > 1 ? argv[1] : "output.ppm";
+	std::string output = argc > 2 ? argv[2] : "dithering.ppm";
 
-	// Paleta em Lab
-	const int grayLevels = 1024;
-	auto levels = build_gray_Levels(grayLevels);
-	std::vector<Lab> palette;
-	for (auto &l : levels) {
-		palette.push_back(rgb2Lab(l));
-	}
-
-	outData.resize(npix);
-	// Kernel de Atkinson
-	const int dx[6] = {1, 2, -1, 0, 1, 0};
-	const int dy[6] = {0, 0, 1, 1, 1, 2};
-
-	for (int y = 0; y < height; ++y) {
-		for (int x = 0; x < width; ++x) {
-			int idx = y * width + x;
-			Lab oldLab = buf[idx];
-			int pi = find_nearest_color(oldLab, palette);
-			Lab best = palette[pi];
-
-			// Convertendo paleta de volta a RGB
-			outData[idx] = levels[pi];
-
-			// Erro em Lab
-			Lab err;
-			err.L = oldLab.L - best.L;
-			err.a = oldLab.a - best.a;
-			err.b = oldLab.b - best.b;
-			// Fixar pixel
-			buf[idx] = best;
-			// Difundir erro
-			for (int k = 0; k < 6; ++k) {
-				int nx = x + dx[k];
-				int ny = y + dy[k];
-
-				if (nx < 0 || nx >= width || ny < 0 || ny >= height)
-					continue;
-
-				int nidx = ny * width + nx;
-				buf[nidx].L += err.L / 8.0f;
-				buf[nidx].a += err.a / 8.0f;
-				buf[nidx].b += err.b / 8.0f;
-			}
-		}
-	}
-}
-
-int main(void) {
 	std::vector<RGB> data;
 	int width, height, maxValue;
-	if (!readPPM("output.ppm", data, width, height, maxValue)) {
+	if (!readPPM(input, data, width, height, maxValue)) {
 		return 1;
 	}
 
-	std::vector<RGB> output;
-	atkinsonDither(data, output, width, height);
-	if (!writePPM("dithering.ppm", output, width, height, maxValue)) {
+	std::vector<RGB> out;
+	atkinsonDither(data, out, width, height);
+	if (!writePPM(output, out, width, height, maxValue)) {
 		return 1;
 	}
 
@@ -0,0 +1,206 @@
+#include "palette_cache.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <numeric>
+
+namespace {
+
+const int L_BUCKETS = 256;
+const size_t DEFAULT_BUDGET = 64u << 20;
+
+uint64_t hash_colors(const RGB *colors, size_t n) {
+	// FNV-1a de 64 bits sobre os bytes da paleta
+	uint64_t h = 1469598103934665603ull;
+	for (size_t i = 0; i < n; ++i) {
+		const unsigned char bytes[3] = {colors[i].r, colors[i].g, colors[i].b};
+		for (unsigned char c : bytes) {
+			h ^= c;
+			h *= 1099511628211ull;
+		}
+	}
+	return h ^ n;
+}
+
+bool same_colors(const std::vector<RGB> &a, const RGB *b, size_t n) {
+	if (a.size() != n)
+		return false;
+	for (size_t i = 0; i < n; ++i)
+		if (a[i].r != b[i].r || a[i].g != b[i].g || a[i].b != b[i].b)
+			return false;
+	return true;
+}
+
+} // namespace
+
+PaletteData::PaletteData(std::vector<RGB> colors) : rgb(std::move(colors)) {
+	lab = palette_to_lab(rgb);
+	int n = int(lab.size());
+	order.resize(n);
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return lab[a].L < lab[b].L; });
+	sorted_L.resize(n);
+	for (int i = 0; i < n; ++i)
+		sorted_L[i] = lab[order[i]].L;
+
+	bucket_start.assign(L_BUCKETS + 1, n);
+	if (n == 0)
+		return;
+	min_a = max_a = lab[0].a;
+	min_b = max_b = lab[0].b;
+	for (const Lab &c : lab) {
+		min_a = std::min(min_a, c.a);
+		max_a = std::max(max_a, c.a);
+		min_b = std::min(min_b, c.b);
+		max_b = std::max(max_b, c.b);
+	}
+	min_L = sorted_L.front();
+	float range = sorted_L.back() - min_L;
+	bucket_scale = range > 0.0f ? L_BUCKETS / range : 0.0f;
+	for (int k = 0, pos = 0; k <= L_BUCKETS; ++k) {
+		float start = min_L + (bucket_scale > 0.0f ? k / bucket_scale : 0.0f);
+		while (pos < n && sorted_L[pos] < start)
+			++pos;
+		bucket_start[k] = pos;
+	}
+}
+
+int PaletteData::nearest(const Lab &pixel) const {
+	const int n = int(sorted_L.size());
+	if (n == 0)
+		return 0;
+
+	int k = int((pixel.L - min_L) * bucket_scale);
+	k = std::max(0, std::min(k, L_BUCKETS - 1));
+	int pos = bucket_start[k];
+	while (pos < n && sorted_L[pos] < pixel.L)
+		++pos;
+	while (pos > 0 && sorted_L[pos - 1] >= pixel.L)
+		--pos;
+
+	// distância² mínima de (a, b) do pixel até qualquer cor da paleta
+	float ea = std::max(0.0f, std::max(min_a - pixel.a, pixel.a - max_a));
+	float eb = std::max(0.0f, std::max(min_b - pixel.b, pixel.b - max_b));
+	const float chroma = ea * ea + eb * eb;
+
+	const float inf = std::numeric_limits<float>::infinity();
+	int best_idx = 0;
+	float best_distance = std::numeric_limits<float>::max();
+	int lo = pos - 1, hi = pos;
+	while (lo >= 0 || hi < n) {
+		float dlo = lo >= 0 ? pixel.L - sorted_L[lo] : inf;
+		float dhi = hi < n ? sorted_L[hi] - pixel.L : inf;
+		bool take_hi = dhi <= dlo;
+		float dl = take_hi ? dhi : dlo;
+		// toda entrada restante tem |dL| >= dl, logo distância >= dl² + chroma;
+		// a folga relativa cobre a diferença de arredondamento entre as somas
+		if ((dl * dl + chroma) * (1.0f - 1e-5f) > best_distance)
+			break;
+		int i = order[take_hi ? hi++ : lo--];
+
+		float dL = pixel.L - lab[i].L;
+		float da = pixel.a - lab[i].a;
+		float db = pixel.b - lab[i].b;
+		float dist = dL * dL + da * da + db * db;
+		if (dist < best_distance || (dist == best_distance && i < best_idx)) {
+			best_idx = i;
+			best_distance = dist;
+		}
+	}
+	return best_idx;
+}
+
+Palette PaletteData::view() const {
+	Palette p{rgb, lab};
+	p.accel = this;
+	return p;
+}
+
+size_t PaletteData::bytes() const {
+	return sizeof(*this) + rgb.capacity() * sizeof(RGB) + lab.capacity() * sizeof(Lab) +
+	       order.capacity() * sizeof(int) + sorted_L.capacity() * sizeof(float) +
+	       bucket_start.capacity() * sizeof(int);
+}
+
+PaletteCache::PaletteCache() {
+	st.budget = DEFAULT_BUDGET;
+}
+
+PaletteCache &PaletteCache::instance() {
+	static PaletteCache cache;
+	return cache;
+}
+
+std::shared_ptr<const PaletteData> PaletteCache::get(const RGB *colors, size_t n) {
+	uint64_t h = hash_colors(colors, n);
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		auto range = index.equal_range(h);
+		for (auto it = range.first; it != range.second; ++it) {
+			if (same_colors(it->second->data->rgb, colors, n)) {
+				lru.splice(lru.begin(), lru, it->second);
+				++st.hits;
+				return it->second->data;
+			}
+		}
+		++st.misses;
+	}
+
+	// constrói fora do lock; se outra thread inseriu a mesma paleta nesse
+	// meio tempo, usa a dela
+	auto data = std::make_shared<const PaletteData>(std::vector<RGB>(colors, colors + n));
+
+	std::lock_guard<std::mutex> lock(mutex);
+	auto range = index.equal_range(h);
+	for (auto it = range.first; it != range.second; ++it)
+		if (same_colors(it->second->data->rgb, colors, n))
+			return it->second->data;
+	lru.push_front({h, data});
+	index.emplace(h, lru.begin());
+	st.bytes += data->bytes();
+	++st.entries;
+	evict_locked();
+	return data;
+}
+
+std::shared_ptr<const PaletteData> PaletteCache::get_gray(int levels) {
+	std::vector<RGB> colors = build_gray_Levels(levels);
+	return get(colors);
+}
+
+void PaletteCache::evict_locked() {
+	// mantém sempre a entrada mais recente, mesmo que sozinha passe do orçamento
+	while (st.bytes > st.budget && lru.size() > 1) {
+		Entry &e = lru.back();
+		auto range = index.equal_range(e.hash);
+		for (auto it = range.first; it != range.second; ++it) {
+			if (it->second == std::prev(lru.end())) {
+				index.erase(it);
+				break;
+			}
+		}
+		st.bytes -= e.data->bytes();
+		--st.entries;
+		++st.evictions;
+		lru.pop_back();
+	}
+}
+
+void PaletteCache::set_budget(size_t bytes) {
+	std::lock_guard<std::mutex> lock(mutex);
+	st.budget = bytes;
+	evict_locked();
+}
+
+PaletteCache::Stats PaletteCache::stats() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return st;
+}
+
+void PaletteCache::clear() {
+	std::lock_guard<std::mutex> lock(mutex);
+	lru.clear();
+	index.clear();
+	st.entries = 0;
+	st.bytes = 0;
+}
@@ -0,0 +1,82 @@
+#ifndef PALETTE_CACHE_H
+#define PALETTE_CACHE_H
+
+#include "color.h"
+#include "dither.h"
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Paleta pronta para busca: cores em RGB e Lab, os índices ordenados por L e
+// a caixa envolvente dos (a, b) da paleta (estrutura de aceleração), e uma
+// tabela de baldes por L que dá o ponto de partida da busca sem busca binária.
+struct PaletteData {
+	std::vector<RGB> rgb;
+	std::vector<Lab> lab;
+	std::vector<int> order; // índices da paleta em ordem crescente de L
+	std::vector<float> sorted_L; // L de cada entrada de `order`
+	std::vector<int> bucket_start; // primeira posição de `order` em cada balde de L
+	float min_L = 0.0f, bucket_scale = 0.0f;
+	float min_a = 0.0f, max_a = 0.0f, min_b = 0.0f, max_b = 0.0f;
+
+	explicit PaletteData(std::vector<RGB> colors);
+
+	// Mesmo resultado de find_nearest_color (menor índice em caso de empate),
+	// mas a busca parte do L do pixel e para assim que a diferença de L mais
+	// a distância de (a, b) até a caixa da paleta passa da melhor distância.
+	// Numa paleta de cinzas a caixa é quase um ponto, então a busca para
+	// depois de poucas entradas mesmo para pixels bem saturados.
+	int nearest(const Lab &pixel) const;
+
+	// visão usada pelas funções de dither; aponta de volta para esta paleta
+	Palette view() const;
+	size_t bytes() const;
+};
+
+// Cache de paletas do processo, seguro entre threads. As entradas são
+// indexadas pelo hash do conteúdo da paleta (com comparação completa para
+// descartar colisões), reaproveitadas entre chamadas e descartadas por ordem
+// de uso menos recente quando o total passa do orçamento de memória. Quem
+// pegou uma entrada continua com ela válida mesmo depois do descarte.
+class PaletteCache {
+public:
+	struct Stats {
+		uint64_t hits = 0;
+		uint64_t misses = 0;
+		uint64_t evictions = 0;
+		size_t entries = 0;
+		size_t bytes = 0;
+		size_t budget = 0;
+	};
+
+	static PaletteCache &instance();
+
+	std::shared_ptr<const PaletteData> get(const RGB *colors, size_t n);
+	std::shared_ptr<const PaletteData> get(const std::vector<RGB> &colors) { return get(colors.data(), colors.size()); }
+	// paleta de build_gray_Levels(levels)
+	std::shared_ptr<const PaletteData> get_gray(int levels);
+
+	void set_budget(size_t bytes);
+	Stats stats() const;
+	void clear();
+
+private:
+	struct Entry {
+		uint64_t hash;
+		std::shared_ptr<const PaletteData> data;
+	};
+
+	PaletteCache();
+	void evict_locked();
+
+	mutable std::mutex mutex;
+	std::list<Entry> lru; // mais recente na frente
+	std::unordered_multimap<uint64_t, std::list<Entry>::iterator> index;
+	Stats st;
+};
+
+#endif